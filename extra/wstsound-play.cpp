@@ -100,6 +100,8 @@ void print_usage(int argc, char** argv)
             << "  --abloop A:B       Loop the sample range A:B\n"
             << "  --stream           Stream from file\n"
             << "  --static           Load file into memory\n"
+            << "  --callback         Let the OpenAL mixer pull from file\n"
+            << "  --hybrid           Play the start from memory, stream the rest\n"
             << "  --gain GAIN        Set gain of the source\n"
             << "  --fadein           Fade-in the sound\n"
             << "  --fadeout          Fade-out the sound\n"
@@ -255,9 +257,9 @@ struct FileOptions
 {
   std::filesystem::path filename = {};
   bool loop = false;
-  std::optional<std::tuple<int, int>> abloop = {};
+  std::optional<std::tuple<int64_t, int64_t>> abloop = {};
   SoundSourceType source_type = SoundSourceType::STREAM;
-  float seek = 0;
+  double seek = 0;
   std::array<float, 3> position = { 0.0f, 0.0f, 0.0f };
   std::array<float, 3> velocity = { 0.0f, 0.0f, 0.0f };
   float gain = 1.0f;
@@ -325,7 +327,7 @@ Options parse_args(int argc, char** argv)
         os << argv[i - 1] << " must have exactly INT:INT arguments";
         throw std::runtime_error(os.str());
       } else {
-        return std::tuple<int, int>{std::stoi(values[0]), std::stoi(values[1])};
+        return std::tuple<int64_t, int64_t>{std::stoll(values[0]), std::stoll(values[1])};
       }
     };
 
@@ -377,9 +379,13 @@ Options parse_args(int argc, char** argv)
         file_opts().source_type = SoundSourceType::STREAM;
       } else if (strcmp(argv[i], "--static") == 0) {
         file_opts().source_type = SoundSourceType::STATIC;
+      } else if (strcmp(argv[i], "--callback") == 0) {
+        file_opts().source_type = SoundSourceType::MIXER_CALLBACK;
+      } else if (strcmp(argv[i], "--hybrid") == 0) {
+        file_opts().source_type = SoundSourceType::HYBRID;
       } else if (strcmp(argv[i], "--seek") == 0) {
         next_arg();
-        file_opts().seek = std::stof(argv[i]);
+        file_opts().seek = std::stod(argv[i]);
       } else if (strcmp(argv[i], "--position") == 0) {
         next_arg();
         file_opts().position = arg_parse_vec3(argv[i]);
@@ -33,7 +33,7 @@ public:
   ~FilteredSoundFile() override;
 
   size_t read(void* buffer, size_t buffer_size) override;
-  void seek_to_sample(int sample) override;
+  void seek_to_sample(int64_t sample) override;
   size_t get_size() const override;
   SoundFormat get_format() const override;
 
@@ -20,6 +20,7 @@
 #define HEADER_WSTSOUND_FWD_HPP
 
 #include <memory>
+#include <stdint.h>
 
 namespace wstsound {
 
@@ -38,13 +39,16 @@ class OpenALSystem;
 class OpenalContext;
 class OpusSoundFile;
 class ProceduralSoundFile;
+class PushSoundSource;
 class SoundChannel;
 class SoundFile;
 class SoundManager;
 class SoundSource;
+class StreamBufferPolicy;
 class WavSoundFile;
 
 enum class FadeState;
+enum class SoundId : uint32_t;
 enum class SoundSourceType;
 
 using OpenALBufferPtr = std::shared_ptr<OpenALBuffer>;
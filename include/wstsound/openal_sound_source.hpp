@@ -40,21 +40,21 @@ public:
   SourceState get_state() const override;
 
   void set_looping(bool looping) override;
-  void set_loop(int sample_beg, int sample_end) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
 
   /// Set volume (0.0 is silent, 1.0 is normal)
   void  set_gain(float gain) override;
   float get_gain() const override;
   void set_pitch(float pitch) override;
 
-  void  seek_to(float sec) override;
-  void  seek_to_sample(int sample) override;
+  void  seek_to(double sec) override;
+  void  seek_to_sample(int64_t sample) override;
 
   /** Return the current position in seconds */
-  float get_pos() const override;
+  double get_pos() const override;
 
   /** Seems to be limited to an accuracy of 1024 samples */
-  int get_sample_pos() const override;
+  int64_t get_sample_pos() const override;
 
   void set_relative(bool relative) override;
   void set_position(float x, float y, float z) override;
@@ -0,0 +1,105 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_PRELOAD_JOB_HPP
+#define HEADER_WSTSOUND_PRELOAD_JOB_HPP
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sound_format.hpp"
+
+namespace wstsound {
+
+/** Runs a task somewhere off the calling thread, e.g. on the job
+    system of the application */
+using PreloadExecutor = std::function<void (std::function<void ()>)>;
+
+/** Progress of a SoundManager::preload_async() call. Files are decoded
+    by the executor and uploaded to OpenAL in SoundManager::update(). */
+class PreloadJob
+{
+public:
+  PreloadJob(size_t total);
+
+  size_t get_total() const { return m_total; }
+
+  /** Number of files that are uploaded, failed or were cached already */
+  size_t get_done() const { return m_done; }
+
+  /** Between 0 and 1 */
+  float get_progress() const;
+
+  /** Skip the files that weren't decoded yet and drop those that
+      weren't uploaded, the job finishes in the next update() */
+  void cancel() { m_cancelled = true; }
+  bool is_cancelled() const { return m_cancelled; }
+
+  bool is_finished() const { return m_finished; }
+
+  /** Becomes ready when the job is finished */
+  std::shared_future<void> get_future() const { return m_future; }
+
+  /** Files that couldn't be loaded and why */
+  std::vector<std::pair<std::filesystem::path, std::string>> get_errors() const;
+
+private:
+  friend class SoundManager;
+
+  /** A file decoded by a task, waiting for the thread owning OpenAL */
+  struct Decoded
+  {
+    std::filesystem::path filename;
+    SoundFormat format;
+    std::vector<char> data;
+    std::string error;
+  };
+
+  size_t m_total;
+  std::atomic<size_t> m_done;
+  std::atomic<bool> m_cancelled;
+  std::atomic<bool> m_finished;
+  std::promise<void> m_promise;
+  std::shared_future<void> m_future;
+
+  mutable std::mutex m_mutex;
+
+  /** Tasks that haven't delivered their file yet */
+  size_t m_outstanding;
+  std::vector<Decoded> m_decoded;
+  std::vector<std::pair<std::filesystem::path, std::string>> m_errors;
+
+private:
+  PreloadJob(const PreloadJob&) = delete;
+  PreloadJob& operator=(const PreloadJob&) = delete;
+};
+
+using PreloadJobPtr = std::shared_ptr<PreloadJob>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -30,7 +30,7 @@ public:
   ProceduralSoundFile();
 
   size_t read(void* buffer, size_t buffer_size) override;
-  void seek_to_sample(int sample) override;
+  void seek_to_sample(int64_t sample) override;
   SoundFormat get_format() const override { return m_format; }
   size_t get_size() const override { return m_size; }
 
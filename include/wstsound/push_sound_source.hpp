@@ -0,0 +1,165 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_PUSH_SOUND_SOURCE_HPP
+#define HEADER_WSTSOUND_PUSH_SOUND_SOURCE_HPP
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <vector>
+
+#include "openal_sound_source.hpp"
+#include "sound_format.hpp"
+
+namespace wstsound {
+
+class RingBuffer;
+
+/** Latency settings of a PushSoundSource, all in seconds */
+struct JitterBufferConfig
+{
+  /** Audio kept buffered ahead of the mixer, playback starts once
+      this much was pushed */
+  float target_latency = 0.08f;
+
+  /** Capacity of the jitter buffer, pushes beyond it are dropped */
+  float max_latency = 0.5f;
+
+  /** Size of the AL buffers, three of them are kept queued */
+  float fragment_duration = 0.02f;
+
+  /** Largest pitch change used to pull the buffer back to the
+      target latency when the clocks of producer and device drift */
+  float max_drift_correction = 0.01f;
+};
+
+/** Plays PCM that the application pushes in at runtime, e.g. decoded
+    voice chat or generated audio. The data goes through a lock-free
+    jitter buffer, push() can be called from one producer thread while
+    the source gets updated on the main thread. On underrun the last
+    fragment is faded out, then silence is played till the buffer is
+    back at the target latency. */
+class PushSoundSource : public OpenALSoundSource
+{
+public:
+  struct Stats
+  {
+    /** Seconds of audio buffered, averaged over recent updates */
+    float buffered;
+
+    /** Range of the buffered audio since the last reset_stats() */
+    float min_buffered;
+    float max_buffered;
+
+    /** Current playback rate correction, 1.0 is none */
+    float drift_ratio;
+
+    /** Fragments concealed or filled with silence */
+    int underruns;
+
+    /** push() calls that didn't fit into the jitter buffer */
+    int overruns;
+  };
+
+public:
+  PushSoundSource(SoundChannel& channel, SoundFormat const& format,
+                  JitterBufferConfig const& config);
+  ~PushSoundSource() override;
+
+  /** Append 'len' bytes of PCM in the source's format, returns the
+      number of bytes accepted. Safe to call from the producer thread. */
+  size_t push(void const* data, size_t len);
+
+  SoundFormat const& get_format() const { return m_format; }
+  Stats get_stats() const;
+  void reset_stats();
+
+  void play() override;
+  void pause() override;
+  void finish() override;
+
+  SourceState get_state() const override { return m_state; }
+
+  /** Live audio has no known duration */
+  double get_duration() const override { return 0.0f; }
+  int64_t get_sample_duration() const override { return 0; }
+
+  /** Not supported, throw SoundError */
+  void set_looping(bool looping) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
+  void seek_to(double sec) override;
+  void seek_to_sample(int64_t sample) override;
+
+  void set_pitch(float pitch) override;
+
+  /** Samples played since the start */
+  double get_pos() const override;
+  int64_t get_sample_pos() const override;
+
+  void update(float delta) override;
+
+  int64_t sec_to_sample(double sec) const override;
+  double sample_to_sec(int64_t sample) const override;
+
+private:
+  void unqueue_buffers();
+  void queue_fragment(size_t len);
+  void conceal_fragment();
+  void update_drift();
+
+  /** Seconds of audio in the jitter buffer and the AL queue */
+  float get_buffered() const;
+
+private:
+  SoundFormat m_format;
+  ALenum m_al_format;
+  JitterBufferConfig m_config;
+  std::unique_ptr<RingBuffer> m_ring;
+  size_t m_fragment_size;
+  size_t m_target_size;
+  std::vector<ALuint> m_buffers;
+  std::vector<ALuint> m_free_buffers;
+  std::vector<char> m_fragment;
+
+  /** Fragments concealed in a row */
+  int m_concealed;
+
+  /** Waiting for the jitter buffer to reach the target latency */
+  bool m_buffering;
+  int64_t m_queued_samples;
+  int64_t m_total_samples_processed;
+  float m_pitch;
+  float m_drift_ratio;
+  float m_buffered;
+  float m_min_buffered;
+  float m_max_buffered;
+  int m_underruns;
+  std::atomic<int> m_overruns;
+  SourceState m_state;
+
+private:
+  PushSoundSource(const PushSoundSource&) = delete;
+  PushSoundSource& operator=(const PushSoundSource&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
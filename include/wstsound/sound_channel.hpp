@@ -23,6 +23,8 @@
 #include <vector>
 
 #include "fwd.hpp"
+#include "push_sound_source.hpp"
+#include "sound_id.hpp"
 #include "sound_source_type.hpp"
 
 namespace wstsound {
@@ -42,12 +44,45 @@ public:
   SoundSourcePtr prepare(std::filesystem::path const& filename,
                          SoundSourceType type = SoundSourceType::STATIC);
 
+  /** Like play() and prepare() for a filename, but a cached STATIC
+      sound is found without any path lookup */
+  SoundSourcePtr play(SoundId id, SoundSourceType type = SoundSourceType::STATIC);
+  SoundSourcePtr prepare(SoundId id, SoundSourceType type = SoundSourceType::STATIC);
+
+  /** Like prepare(), but the file is opened in the background, the
+      source is in SourceState::Loading till then. A play() issued
+      while loading takes effect once the source is ready. */
+  SoundSourcePtr play_async(std::filesystem::path const& filename,
+                            SoundSourceType type = SoundSourceType::STREAM);
+  SoundSourcePtr prepare_async(std::filesystem::path const& filename,
+                               SoundSourceType type = SoundSourceType::STREAM);
+
   SoundSourcePtr play(std::unique_ptr<SoundFile> sound_file,
                       SoundSourceType type = SoundSourceType::STATIC);
 
   SoundSourcePtr prepare(std::unique_ptr<SoundFile> sound_file,
                          SoundSourceType type = SoundSourceType::STATIC);
 
+  /** Create a source for PCM pushed in at runtime, returns nullptr
+      if no audio device is available */
+  std::shared_ptr<PushSoundSource> prepare_push(SoundFormat const& format,
+                                                JitterBufferConfig const& config = {});
+
+  /** Play 'filenames' as stems of one track, they are streamed
+      sample-locked and mixed with SoundSource::set_stem_gain() */
+  SoundSourcePtr play_stems(std::vector<std::filesystem::path> const& filenames);
+  SoundSourcePtr prepare_stems(std::vector<std::filesystem::path> const& filenames);
+
+  /** Crossfade from the most recently started source that is still
+      playing to 'filename'. If that source is streaming and the
+      formats match, both files are mixed sample-accurately with an
+      equal-power curve within it, starting at the current play
+      position, and the old source is returned. Otherwise a new source
+      fades in while all playing sources fade out with set_fading(),
+      both with FadeCurve::EqualPower. */
+  SoundSourcePtr crossfade_to(std::filesystem::path const& filename, float duration,
+                              SoundSourceType type = SoundSourceType::STREAM);
+
   void update(float delta);
 
   // volume is clamped to [0,1]
@@ -21,6 +21,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <stdint.h>
 #include <string>
 
 #include "sound_format.hpp"
@@ -47,7 +48,7 @@ public:
   virtual bool eof() const { return tell() == get_size(); }
 
   /** Move the current position in the virtual file to 'sample' */
-  virtual void seek_to_sample(int sample) = 0;
+  virtual void seek_to_sample(int64_t sample) = 0;
 
   /** The size of the virtual file in bytes */
   virtual size_t get_size() const = 0;
@@ -56,10 +57,10 @@ public:
   virtual SoundFormat get_format() const = 0;
 
   /** Returns the length of the file in seconds */
-  float get_duration() const;
+  double get_duration() const;
 
   /** Returns the number of samples in the file */
-  int get_sample_duration() const;
+  int64_t get_sample_duration() const;
 
 public:
   static std::unique_ptr<SoundFile> from_file(std::filesystem::path const& filename);
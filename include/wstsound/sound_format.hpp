@@ -20,6 +20,7 @@
 #define HEADER_WSTSOUND_SOUND_FORMAT_HPP
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <al.h>
 
@@ -41,7 +42,7 @@ public:
   int get_channels() const { return m_channels; }
 
   /** Calculate the number of bytes used by the given samples */
-  size_t sample2bytes(int sample) const;
+  size_t sample2bytes(int64_t sample) const;
 
   ALenum get_openal_format() const;
 
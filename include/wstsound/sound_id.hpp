@@ -0,0 +1,35 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_SOUND_ID_HPP
+#define HEADER_WSTSOUND_SOUND_ID_HPP
+
+#include <stdint.h>
+
+namespace wstsound {
+
+/** Handle of a file registered with SoundManager::register_sound(),
+    an index into its table of sounds. Only valid for the SoundManager
+    that returned it. */
+enum class SoundId : uint32_t {};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -23,18 +23,35 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
+#include <span>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "openal_system.hpp"
+#include "preload_job.hpp"
 #include "sound_channel.hpp"
 #include "listener.hpp"
+#include "push_sound_source.hpp"
+#include "sound_id.hpp"
+#include "stream_buffer_policy.hpp"
 
 namespace wstsound {
 
+template<typename Key, typename Value> class BufferCache;
+class DecodeWorker;
+struct HybridHead;
+class PCMDiskCache;
+class ReadAheadIO;
+class RefillScheduler;
 class SoundFile;
 class SoundSource;
+class SourceEvents;
+class StreamBufferPool;
+class StreamHibernation;
 class StreamSoundSource;
+class TaskPool;
 
 using OpenFunc = std::function<std::unique_ptr<std::istream> (std::filesystem::path)>;
 
@@ -62,7 +79,105 @@ public:
 
   void update(float delta);
 
-  void preload(std::filesystem::path const& filename);
+  /** Load the static buffer, or for HYBRID the cached head, ahead of
+      the first use */
+  void preload(std::filesystem::path const& filename,
+               SoundSourceType type = SoundSourceType::STATIC);
+
+  /** Keep the decoded PCM of STATIC files in 'directory', so later
+      runs load them without decoding. At most 'max_bytes' are kept,
+      least recently used entries are removed first, 0 means no
+      limit. An empty directory disables the cache. Entries are
+      invalidated when the source file changes. New entries are
+      written in the background, like preload_async() decodes. With
+      an OpenFunc every lookup reads the whole source file to check
+      for changes. */
+  void set_disk_cache(std::filesystem::path const& directory, uint64_t max_bytes = 0);
+
+  /** Intern 'filename' for the SoundId overloads, registering the
+      same file again returns the same id */
+  SoundId register_sound(std::filesystem::path const& filename);
+
+  /** The file 'id' was registered with, throws std::invalid_argument
+      for an unknown id */
+  std::filesystem::path const& get_filename(SoundId id) const;
+
+  /** Like preload() for STATIC, but the files are decoded in parallel
+      by the preload executor and uploaded in update(). Files that are
+      cached already count as done right away. */
+  PreloadJobPtr preload_async(std::span<std::filesystem::path const> filenames);
+
+  /** Run the decoding of preload_async() and the opening of files
+      for create_sound_source_async() through 'executor' instead of
+      the internal thread pool, an empty executor restores it. The
+      tail of a HYBRID source with a cached head is opened there too. */
+  void set_preload_executor(PreloadExecutor executor);
+
+  /** Let create_sound_source() for a STATIC sound that isn't cached
+      return right away and load the file via preload_async(). The
+      source is in SourceState::Loading meanwhile, once the buffer is
+      there it starts at the position it would have reached by then,
+      or is dropped if that is more than 'max_latency' seconds late.
+      Looping sources are never dropped. Disabled by default, which
+      decodes the file in create_sound_source(). */
+  void set_deferred_static_loading(bool enable, float max_latency = 0.1f);
+
+  /** Limit the memory used by cached STATIC buffers, their loop
+      variants and HYBRID heads to 'bytes'. Once exceeded, the least
+      recently used buffers no source plays anymore are dropped. 0,
+      the default, means no limit. */
+  void set_buffer_cache_budget(size_t bytes);
+
+  /** Bytes of all cached buffers, including those in use */
+  size_t get_buffer_cache_size() const;
+
+  /** Keep the cached buffers of 'filename' regardless of the budget
+      and clear_buffer_cache(), works before and after preload() */
+  void pin(std::filesystem::path const& filename);
+  void unpin(std::filesystem::path const& filename);
+
+  /** Drop the cached buffers of 'filename', pinned or not. Sources
+      still playing it keep their buffer till they are gone. */
+  void unload(std::filesystem::path const& filename);
+
+  /** Drop all cached buffers that are not pinned */
+  void clear_buffer_cache();
+
+  /** Decode streaming sources ahead of time on 'num_threads'
+      background threads instead of in update(), 0 disables the
+      background decoding. Only affects sources created afterwards. */
+  void set_decode_threads(int num_threads);
+
+  /** Limit the bytes streaming sources queue per update(), the
+      sources closest to running dry get refilled first. 0 disables
+      the limit and every source refills itself in its update(). */
+  void set_refill_budget(size_t bytes);
+
+  /** Let streaming sources created afterwards wait for AL_SOFT_events
+      instead of querying OpenAL in every update(), does nothing when
+      the extension isn't available */
+  void set_event_driven_updates(bool enable);
+
+  /** Release the decoder, file handle and AL buffers of streams that
+      were paused or inaudible for 'idle_timeout' seconds, and of the
+      longest idle ones while more than 'max_open_decoders' are open.
+      The stream reopens its file when it becomes audible again. 0
+      disables either limit. Applies to all streaming sources created
+      from a filename. */
+  void set_stream_hibernation(float idle_timeout, size_t max_open_decoders = 0);
+
+  /** Allocate AL buffers for streaming sources up front, e.g. for
+      the number of fragments of the expected peak of concurrent
+      streams, so starting a stream doesn't allocate any */
+  void reserve_stream_buffers(size_t count);
+
+  /** Highest number of streaming AL buffers in use at once, a good
+      value for reserve_stream_buffers() */
+  size_t get_stream_buffer_high_water_mark() const;
+
+  /** Default buffer policy for streaming sources created afterwards */
+  void set_stream_buffer_policy(StreamBufferPolicy const& policy) { m_stream_buffer_policy = policy; }
+  StreamBufferPolicy const& get_stream_buffer_policy() const { return m_stream_buffer_policy; }
 
   /**
    * Creates a new sound source object which plays the specified soundfile.
@@ -79,21 +194,148 @@ public:
                                      SoundChannel& channel,
                                      SoundSourceType type);
 
+  /** Like create_sound_source() for the registered file, a STATIC
+      buffer that is cached is used without looking up the path */
+  SoundSourcePtr create_sound_source(SoundId id, SoundChannel& channel, SoundSourceType type);
+
+  /** Like create_sound_source(), but the file is opened on a
+      background thread. The source is in SourceState::Loading till
+      then and replays calls made in the meantime, e.g. play(), once
+      it's ready. STATIC sources are created right away unless
+      deferred static loading is enabled. */
+  SoundSourcePtr create_sound_source_async(std::filesystem::path const& filename,
+                                           SoundChannel& channel,
+                                           SoundSourceType type);
+
+  /** Create a source that plays PCM pushed in by the application,
+      returns nullptr if no audio device is available */
+  std::shared_ptr<PushSoundSource> create_push_sound_source(SoundFormat const& format,
+                                                            SoundChannel& channel,
+                                                            JitterBufferConfig const& config = {});
+
+  /** Create a source that streams 'filenames' sample-locked, the
+      files must share the same sample rate */
+  SoundSourcePtr create_stem_sound_source(std::vector<std::filesystem::path> const& filenames,
+                                          SoundChannel& channel);
+
+  /** Open a SoundFile via the OpenFunc */
+  std::unique_ptr<SoundFile> load_sound_file(std::filesystem::path const& filename);
+
+  /** Like load_sound_file(), but for files that get streamed, e.g.
+      for SoundSource::enqueue(). With read-ahead enabled the file is
+      read in large chunks on a background thread, so the decoder
+      doesn't wait on the disk. */
+  std::unique_ptr<SoundFile> open_stream_file(std::filesystem::path const& filename);
+
+  /** Enable read-ahead for streamed files opened afterwards, enabled
+      by default */
+  void set_stream_read_ahead(bool read_ahead) { m_stream_read_ahead = read_ahead; }
+
   EffectSlotPtr create_effect_slot();
   EffectPtr create_effect(ALuint effect_type);
   FilterPtr create_filter(ALuint filter_type);
 
 private:
+  /** Entry of m_sounds, see sound_manager.cpp */
+  struct RegisteredSound;
+
+private:
+  SoundSourcePtr create_callback_sound_source(std::unique_ptr<SoundFile> sound_file, SoundChannel& channel);
+  SoundSourcePtr create_hybrid_sound_source(std::filesystem::path const& filename, SoundChannel& channel);
+  SoundSourcePtr create_static_sound_source(std::filesystem::path const& filename, SoundChannel& channel);
+
+  /** A LoadingSoundSource for the STATIC 'filename', which isn't
+      cached yet */
+  SoundSourcePtr create_deferred_static_sound_source(std::filesystem::path const& filename, SoundChannel& channel);
+
+  /** Decode the start of 'sound_file' into a buffer, leaves the file
+      positioned right after it */
+  std::shared_ptr<HybridHead> load_hybrid_head(SoundFile& sound_file);
+
+  /** Decode 'file' into a new buffer, directly into AL memory with
+      AL_SOFT_map_buffer, through m_scratch otherwise */
   OpenALBufferPtr load_file_into_buffer(std::unique_ptr<SoundFile> file);
-  std::unique_ptr<SoundFile> load_sound_file(std::filesystem::path const& filename);
+
+  /** Load all of 'filename' into a new buffer, through the disk
+      cache if enabled */
+  OpenALBufferPtr load_static_buffer(std::filesystem::path const& filename);
+
+  /** Upload the files decoded by preload_async() */
+  void update_preload_jobs();
+
+  /** Run 'task' through the preload executor, or the internal thread
+      pool if there is none. A user executor might run it after the
+      SoundManager is gone, so tasks hold copies and shared state,
+      never 'this'. */
+  void post_task(std::function<void ()> task);
+
+  /** The cached head of 'filename', nullptr if it isn't cached */
+  std::shared_ptr<HybridHead> get_hybrid_head(std::filesystem::path const& filename);
+  void cache_hybrid_head(std::filesystem::path const& filename, HybridHead const& head);
+
+  /** The cached buffer of the whole file, loaded on a miss */
+  OpenALBufferPtr get_static_buffer(std::filesystem::path const& filename);
+
+  /** Copy of the cached buffer for 'filename' with loop points set,
+      shared by all static sources using the same loop. OpenAL can't
+      copy buffers, so each distinct loop range decodes the file again
+      and holds another full copy of its PCM, counted against the
+      buffer cache budget. */
+  OpenALBufferPtr get_loop_buffer(std::filesystem::path const& filename, int64_t sample_beg, int64_t sample_end);
+
+  /** Let 'source' be hibernated, it reopens 'filename' on wake up */
+  void enable_hibernation(StreamSoundSource& source, std::filesystem::path const& filename);
+
+  /** The SourceEvents for new streaming sources, if enabled */
+  std::shared_ptr<SourceEvents> get_stream_source_events() const;
+
+  /** The ReadAheadIO for new streams, if read-ahead is enabled */
+  std::shared_ptr<ReadAheadIO> get_stream_read_ahead_io() const;
 
 private:
   std::unique_ptr<OpenALSystem> m_openal;
   std::function<std::unique_ptr<std::istream> (std::filesystem::path)> m_open_func;
   Listener m_listener;
   std::vector<std::unique_ptr<SoundChannel> > m_channels;
-  std::map<std::filesystem::path, OpenALBufferPtr> m_buffer_cache;
+  /** Whole files, loop variants and HYBRID heads keyed by filename
+      and loop range, see sound_manager.cpp */
+  std::unique_ptr<BufferCache<std::tuple<std::filesystem::path, int64_t, int64_t>, OpenALBufferPtr>> m_buffer_cache;
+
+  /** Everything of a HybridHead but the buffer, which is kept in
+      m_buffer_cache */
+  std::map<std::filesystem::path, std::shared_ptr<HybridHead>> m_hybrid_head_cache;
+  std::set<std::filesystem::path> m_pinned;
+  PreloadExecutor m_preload_executor;
+  std::shared_ptr<TaskPool> m_task_pool;
+  std::vector<PreloadJobPtr> m_preload_jobs;
+  bool m_deferred_static_loading;
+  float m_deferred_static_max_latency;
+  /** Loads started by deferred STATIC sources, so sources of the same
+      file share them */
+  std::map<std::filesystem::path, PreloadJobPtr> m_static_loads;
+  /** Decode memory of load_file_into_buffer() when the AL buffer
+      can't be mapped, kept between loads */
+  std::vector<char> m_scratch;
+  std::shared_ptr<PCMDiskCache> m_disk_cache;
+  /** Indexed by SoundId */
+  std::vector<RegisteredSound> m_sounds;
+  std::map<std::filesystem::path, SoundId> m_sound_ids;
   std::vector<SoundSourcePtr> m_managed_sources;
+  std::shared_ptr<DecodeWorker> m_decode_worker;
+  std::shared_ptr<RefillScheduler> m_refill_scheduler;
+  std::shared_ptr<StreamBufferPool> m_stream_buffer_pool;
+  std::shared_ptr<SourceEvents> m_source_events;
+  std::shared_ptr<StreamHibernation> m_stream_hibernation;
+  bool m_event_driven_updates;
+  StreamBufferPolicy m_stream_buffer_policy;
+  bool m_stream_read_ahead;
+  /** Does the file reads of all read-ahead streams */
+  std::shared_ptr<ReadAheadIO> m_read_ahead_io;
+
+  /** Non-owning, callbacks that sources keep hold a weak_ptr to it, as
+      sources can outlive the SoundManager. Reset first thing in
+      ~SoundManager(). */
+  std::shared_ptr<SoundManager> m_self;
 
 public:
   SoundManager(const SoundManager&);
@@ -21,6 +21,8 @@
 
 #include "fwd.hpp"
 
+#include <memory>
+#include <stdint.h>
 #include <optional>
 
 namespace wstsound {
@@ -31,11 +33,24 @@ enum class FadeDirection
   Out
 };
 
+enum class FadeCurve
+{
+  Linear,
+
+  /** Sine and cosine, a source fading in while another fades out
+      keeps the combined loudness constant */
+  EqualPower
+};
+
 enum class SourceState
 {
   Playing,
   Paused,
-  Finished
+  Finished,
+
+  /** The file is still being opened in the background, see
+      SoundChannel::prepare_async() */
+  Loading
 };
 
 class SoundSource
@@ -46,6 +61,7 @@ public:
     FadeDirection direction;
     float duration;
     float time_passed;
+    FadeCurve curve;
   };
 
 public:
@@ -56,33 +72,62 @@ public:
   virtual void pause() = 0;
   virtual void finish() = 0;
 
+  /** Decode the start of the sound ahead of play(), so play() can
+      start right away. Sources with nothing to decode ignore it. */
+  virtual void preroll() {}
+
   virtual SourceState get_state() const = 0;
 
-  virtual float get_duration() const = 0;
-  virtual int get_sample_duration() const = 0;
+  virtual double get_duration() const = 0;
+  virtual int64_t get_sample_duration() const = 0;
 
-  virtual void set_fading(FadeDirection direction, float duration);
+  virtual void set_fading(FadeDirection direction, float duration,
+                          FadeCurve curve = FadeCurve::Linear);
   virtual std::optional<Fade> const& get_fade() const { return m_fade; }
   virtual void set_looping(bool looping) = 0;
 
   /** Set an A-B loop on the source source. Note that this does not
       seek to the start of the loop instanty, the loop is only
       triggered once reaching `sample_end`. */
-  virtual void set_loop(int sample_beg, int sample_end) = 0;
+  virtual void set_loop(int64_t sample_beg, int64_t sample_end) = 0;
+
+  /** Crossfade the audio following the loop end into the loop start,
+      only supported by streaming sources */
+  virtual void set_loop_crossfade(float duration) {}
+
+  /** Continue playback with 'sound_file' once the current file
+      ended, without a gap. Only supported by streaming sources, the
+      format must match the current file. */
+  virtual void enqueue(std::unique_ptr<SoundFile> sound_file);
 
   /// Set volume (0.0 is silent, 1.0 is normal)
   virtual void  set_gain(float gain) = 0;
   virtual float get_gain() const = 0;
+
+  /** Gain of a single stem, relative to get_gain(), only supported by
+      sources created with SoundChannel::prepare_stems() */
+  virtual void set_stem_gain(int stem, float gain);
   virtual void set_pitch(float pitch) = 0;
 
-  virtual void  seek_to_sample(int sample) = 0;
-  virtual void  seek_to(float sec) = 0;
+  /** Control the amount of audio queued ahead, only affects
+      streaming sources */
+  virtual void set_buffer_policy(StreamBufferPolicy const& policy) {}
+
+  virtual void  seek_to_sample(int64_t sample) = 0;
+  virtual void  seek_to(double sec) = 0;
+
+  /** Seek without interrupting playback, the old audio keeps playing
+      until the new position is decoded and then gets replaced in one
+      go. get_sample_pos() reports the old position till then. Sources
+      that can't do this seek synchronously. */
+  virtual void  seek_to_sample_async(int64_t sample);
+  void seek_to_async(double sec) { seek_to_sample_async(sec_to_sample(sec)); }
 
   /** Return the current position in seconds */
-  virtual float get_pos() const = 0;
+  virtual double get_pos() const = 0;
 
   /** Return the current position in pcm samples */
-  virtual int get_sample_pos() const = 0;
+  virtual int64_t get_sample_pos() const = 0;
 
   /** Set position to be relative to the camera */
   virtual void set_relative(bool relative) = 0;
@@ -106,8 +151,8 @@ public:
 
   virtual void update(float delta);
 
-  virtual int sec_to_sample(float sec) const = 0;
-  virtual float sample_to_sec(int sample) const = 0;
+  virtual int64_t sec_to_sample(double sec) const = 0;
+  virtual double sample_to_sec(int64_t sample) const = 0;
 
 protected:
   std::optional<Fade> m_fade;
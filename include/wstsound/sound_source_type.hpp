@@ -23,7 +23,17 @@ namespace wstsound {
 
 enum class SoundSourceType {
   STATIC,
-  STREAM
+  STREAM,
+
+  /** Stream where the OpenAL mixer pulls the samples itself, requires
+      AL_SOFT_callback_buffer and falls back to STREAM without it */
+  MIXER_CALLBACK,
+
+  /** Plays the start of the file from a cached static buffer and
+      streams the rest, for long one-shots that need to start
+      instantly. The first use decodes the head synchronously, see
+      SoundManager::preload() to do that up front. */
+  HYBRID
 };
 
 } // namespace wstsound
@@ -0,0 +1,80 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_STREAM_BUFFER_POLICY_HPP
+#define HEADER_WSTSOUND_STREAM_BUFFER_POLICY_HPP
+
+#include <stddef.h>
+
+namespace wstsound {
+
+class SoundFormat;
+
+/** Controls how much audio a streaming source keeps queued in OpenAL */
+class StreamBufferPolicy final
+{
+public:
+  /** Always queue 'fragments' buffers of 'fragment_size' bytes */
+  static StreamBufferPolicy fixed(int fragments, size_t fragment_size);
+
+  /** Size the queue from the byte rate of the stream, the current
+      pitch and the measured interval between update() calls, grow it
+      after an underrun and shrink it again once playback is stable.
+      The queue always holds between 'min_latency' and 'max_latency'
+      seconds of audio. */
+  static StreamBufferPolicy adaptive(float min_latency = 0.1f, float max_latency = 2.0f);
+
+public:
+  /** 4 fragments of 64KiB each */
+  StreamBufferPolicy();
+
+  bool is_adaptive() const { return m_adaptive; }
+
+  int get_fragments() const { return m_fragments; }
+  size_t get_fragment_size() const { return m_fragment_size; }
+
+  float get_min_latency() const { return m_min_latency; }
+  float get_max_latency() const { return m_max_latency; }
+
+  /** This policy if it's fixed, the default one otherwise. For
+      sources whose depth can't adapt, like the short lived tail of a
+      HYBRID source or stems, whose fragments have to line up. */
+  StreamBufferPolicy get_fixed() const;
+
+  /** The largest number of bytes the policy will ever keep queued */
+  size_t get_max_bytes(SoundFormat const& format) const;
+
+public:
+  static const int MIN_FRAGMENTS = 3;
+  static const int MAX_FRAGMENTS = 16;
+  static const size_t MIN_FRAGMENT_SIZE = 4096;
+  static const size_t MAX_FRAGMENT_SIZE = 262144;
+
+private:
+  bool m_adaptive;
+  int m_fragments;
+  size_t m_fragment_size;
+  float m_min_latency;
+  float m_max_latency;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -0,0 +1,210 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_BUFFER_CACHE_HPP
+#define HEADER_WSTSOUND_BUFFER_CACHE_HPP
+
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace wstsound {
+
+/** Cache of shared_ptr values with a byte budget. Once the budget is
+    exceeded, entries that are only referenced by the cache itself and
+    not pinned are evicted, least recently used first. Entries still
+    in use can push the size over the budget, they are evicted by a
+    later trim() once released. */
+template<typename Key, typename Value>
+class BufferCache
+{
+private:
+  struct Entry
+  {
+    Value value;
+    size_t bytes;
+    bool pinned;
+    uint64_t last_use;
+  };
+
+public:
+  /** Refers to an entry without a lookup, expires when the entry is
+      evicted or erased */
+  using Ref = std::weak_ptr<Entry>;
+
+public:
+  BufferCache() :
+    m_budget(0),
+    m_size(0),
+    m_tick(0),
+    m_entries()
+  {}
+
+  /** 0 means no limit */
+  void set_budget(size_t bytes)
+  {
+    m_budget = bytes;
+    trim();
+  }
+
+  size_t get_budget() const { return m_budget; }
+
+  /** Bytes of all cached entries, including those in use */
+  size_t get_size() const { return m_size; }
+
+  size_t get_count() const { return m_entries.size(); }
+
+  bool contains(Key const& key) const { return m_entries.contains(key); }
+
+  /** Returns the cached value and marks it as recently used, or an
+      empty Value */
+  Value get(Key const& key)
+  {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+      return {};
+    }
+
+    it->second->last_use = ++m_tick;
+    return it->second->value;
+  }
+
+  /** Like get(), but through a Ref from get_ref() */
+  Value get(Ref const& ref)
+  {
+    auto entry = ref.lock();
+    if (!entry) {
+      return {};
+    }
+
+    entry->last_use = ++m_tick;
+    return entry->value;
+  }
+
+  Ref get_ref(Key const& key) const
+  {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+      return {};
+    }
+    return it->second;
+  }
+
+  void insert(Key const& key, Value value, size_t bytes, bool pinned = false)
+  {
+    erase(key);
+
+    m_entries.emplace(key, std::make_shared<Entry>(Entry{std::move(value), bytes, pinned, ++m_tick}));
+    m_size += bytes;
+
+    trim();
+  }
+
+  void set_pinned(Key const& key, bool pinned)
+  {
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+      it->second->pinned = pinned;
+    }
+  }
+
+  bool erase(Key const& key)
+  {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+      return false;
+    }
+
+    m_size -= it->second->bytes;
+    m_entries.erase(it);
+    return true;
+  }
+
+  /** Erase all entries whose key matches 'pred', returns their number */
+  template<typename Pred>
+  size_t erase_if(Pred pred)
+  {
+    size_t count = 0;
+    for(auto it = m_entries.begin(); it != m_entries.end();) {
+      if (pred(it->first)) {
+        m_size -= it->second->bytes;
+        it = m_entries.erase(it);
+        count += 1;
+      } else {
+        ++it;
+      }
+    }
+    return count;
+  }
+
+  /** Erase all entries that are not pinned */
+  void clear()
+  {
+    for(auto it = m_entries.begin(); it != m_entries.end();) {
+      if (!it->second->pinned) {
+        m_size -= it->second->bytes;
+        it = m_entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  /** Evict unused entries till the cache fits the budget */
+  void trim()
+  {
+    while (m_budget > 0 && m_size > m_budget)
+    {
+      auto lru = m_entries.end();
+      for(auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (!it->second->pinned && it->second->value.use_count() <= 1 &&
+            (lru == m_entries.end() || it->second->last_use < lru->second->last_use)) {
+          lru = it;
+        }
+      }
+
+      if (lru == m_entries.end()) {
+        // everything left is in use or pinned
+        break;
+      }
+
+      m_size -= lru->second->bytes;
+      m_entries.erase(lru);
+    }
+  }
+
+  bool over_budget() const { return m_budget > 0 && m_size > m_budget; }
+
+private:
+  size_t m_budget;
+  size_t m_size;
+  uint64_t m_tick;
+  /** shared_ptr so Refs can point at them */
+  std::map<Key, std::shared_ptr<Entry>> m_entries;
+
+private:
+  BufferCache(const BufferCache&) = delete;
+  BufferCache& operator=(const BufferCache&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
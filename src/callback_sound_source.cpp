@@ -0,0 +1,335 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "callback_sound_source.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+
+#define AL_ALEXT_PROTOTYPES
+#include <alext.h>
+
+#include "sound_error.hpp"
+#include "sound_file.hpp"
+#include "sound_manager.hpp"
+
+namespace wstsound {
+
+bool
+CallbackSoundSource::is_supported()
+{
+  return alIsExtensionPresent("AL_SOFT_callback_buffer") == AL_TRUE;
+}
+
+CallbackSoundSource::CallbackSoundSource(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file,
+                                         DecodeWorkerPtr decode_worker,
+                                         StreamBufferPolicy const& policy) :
+  OpenALSoundSource(channel),
+  m_reader(),
+  m_decode_worker(std::move(decode_worker)),
+  m_buffer(),
+  m_state(SourceState::Paused),
+  m_start_sample(0),
+  m_sample_duration(sound_file->get_sample_duration()),
+  m_samples_consumed(0),
+  m_underruns(0)
+{
+  if (!is_supported()) {
+    throw SoundError("CallbackSoundSource: AL_SOFT_callback_buffer not supported");
+  }
+
+  SoundFormat const format = sound_file->get_format();
+
+  // the mixer can only read from a ring buffer, so one is needed even
+  // when there is no worker thread to fill it
+  m_reader = std::make_shared<StreamReader>(std::move(sound_file), policy.get_max_bytes(format));
+
+  alGenBuffers(1, &m_buffer);
+  OpenALSystem::check_al_error("Couldn't allocate audio buffer: ");
+
+  alBufferCallbackSOFT(m_buffer, format.get_openal_format(), format.get_rate(), &cb_buffer, this);
+  OpenALSystem::check_al_error("Couldn't set buffer callback: ");
+
+  alSourcei(m_source, AL_BUFFER, static_cast<ALint>(m_buffer));
+  OpenALSystem::check_al_error("Couldn't attach callback buffer: ");
+
+  if (m_decode_worker) {
+    m_decode_worker->add(m_reader);
+  }
+}
+
+CallbackSoundSource::~CallbackSoundSource()
+{
+  stop();
+
+  alSourcei(m_source, AL_BUFFER, AL_NONE);
+  alDeleteBuffers(1, &m_buffer);
+  OpenALSystem::warn_al_error("Couldn't delete audio buffer: ");
+
+  if (m_decode_worker) {
+    m_reader->cancel();
+    m_decode_worker->remove(m_reader);
+  }
+}
+
+void
+CallbackSoundSource::play()
+{
+  if (m_state == SourceState::Playing) { return; }
+
+  m_state = SourceState::Playing;
+
+  if (!m_reader->ready(1)) {
+    // have something ready for the very first callback
+    m_reader->fill();
+  }
+
+  OpenALSoundSource::play();
+}
+
+void
+CallbackSoundSource::preroll()
+{
+  if (m_state == SourceState::Playing) { return; }
+
+  if (!m_reader->ready(1)) {
+    m_reader->fill();
+  }
+}
+
+void
+CallbackSoundSource::pause()
+{
+  if (m_state == SourceState::Paused) { return; }
+
+  m_state = SourceState::Paused;
+
+  OpenALSoundSource::pause();
+}
+
+void
+CallbackSoundSource::finish()
+{
+  if (m_state == SourceState::Finished) { return; }
+
+  m_state = SourceState::Finished;
+
+  stop();
+}
+
+void
+CallbackSoundSource::stop()
+{
+  // openal-soft waits for the mixer to let go of the source, so the
+  // callback is guaranteed to not be running afterwards
+  OpenALSoundSource::finish();
+}
+
+void
+CallbackSoundSource::update(float delta)
+{
+  OpenALSoundSource::update(delta);
+
+  if (m_state != SourceState::Finished && m_reader->is_seek_ready()) {
+    stop();
+    m_start_sample = m_reader->complete_seek();
+    m_samples_consumed = 0;
+
+    if (m_state == SourceState::Playing) {
+      OpenALSoundSource::play();
+    }
+  }
+
+  if (m_state != SourceState::Playing) { return; }
+
+  if (m_decode_worker) {
+    m_decode_worker->notify();
+  } else {
+    while (m_reader->fill()) {}
+  }
+
+  update_transitions();
+
+  int const underruns = m_underruns.exchange(0);
+  if (underruns > 0) {
+    std::cerr << "CallbackSoundSource: decoder underrun, played " << underruns << " blocks of silence.\n";
+  }
+
+  ALint state = AL_STOPPED;
+  alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+  if (state == AL_STOPPED)
+  {
+    if (m_reader->eof()) {
+      m_state = SourceState::Finished;
+    } else {
+      OpenALSoundSource::play();
+    }
+  }
+}
+
+void
+CallbackSoundSource::seek_to(double sec)
+{
+  seek_to_sample(sec_to_sample(sec));
+}
+
+void
+CallbackSoundSource::seek_to_sample(int64_t sample)
+{
+  stop();
+
+  m_reader->seek_to_sample(sample);
+  m_start_sample = sample;
+  m_samples_consumed = 0;
+
+  if (m_state == SourceState::Playing) {
+    m_reader->fill();
+    OpenALSoundSource::play();
+  }
+}
+
+void
+CallbackSoundSource::seek_to_sample_async(int64_t sample)
+{
+  // the mixer keeps playing the old data until update() sees the
+  // new position decoded
+  m_reader->request_seek(sample);
+  if (m_decode_worker) {
+    m_decode_worker->notify();
+  }
+}
+
+void
+CallbackSoundSource::set_looping(bool looping)
+{
+  if (looping) {
+    m_reader->set_loop(StreamReader::Loop{0, m_sample_duration});
+  } else {
+    m_reader->set_loop(std::nullopt);
+  }
+}
+
+void
+CallbackSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
+{
+  if (sample_beg > sample_end) {
+    throw std::invalid_argument("CallbackSoundSource::set_loop(): invalid loop range");
+  }
+
+  m_reader->set_loop(StreamReader::Loop{
+      std::max<int64_t>(sample_beg, 0),
+      std::min(sample_end, m_sample_duration)
+    });
+}
+
+void
+CallbackSoundSource::set_loop_crossfade(float duration)
+{
+  m_reader->set_loop_crossfade(static_cast<int>(sec_to_sample(duration)));
+}
+
+void
+CallbackSoundSource::enqueue(std::unique_ptr<SoundFile> sound_file)
+{
+  m_reader->enqueue(std::move(sound_file));
+}
+
+double
+CallbackSoundSource::get_pos() const
+{
+  return sample_to_sec(get_sample_pos());
+}
+
+double
+CallbackSoundSource::get_duration() const
+{
+  return sample_to_sec(m_sample_duration);
+}
+
+int64_t
+CallbackSoundSource::get_sample_pos() const
+{
+  // accurate to the mixer's update size, OpenAL requests data
+  // slightly ahead of what is audible
+  return m_start_sample + m_samples_consumed;
+}
+
+int64_t
+CallbackSoundSource::get_sample_duration() const
+{
+  return m_sample_duration;
+}
+
+double
+CallbackSoundSource::sample_to_sec(int64_t sample) const
+{
+  return static_cast<double>(sample) / static_cast<double>(m_reader->get_format().get_rate());
+}
+
+int64_t
+CallbackSoundSource::sec_to_sample(double sec) const
+{
+  return static_cast<int64_t>(sec * static_cast<double>(m_reader->get_format().get_rate()));
+}
+
+void
+CallbackSoundSource::update_transitions()
+{
+  while (auto transition = m_reader->next_transition())
+  {
+    if (get_sample_pos() < transition->sample) {
+      break;
+    }
+
+    m_start_sample -= transition->sample;
+    m_sample_duration = transition->sample_duration;
+    m_reader->pop_transition();
+  }
+}
+
+ALsizei AL_APIENTRY
+CallbackSoundSource::cb_buffer(ALvoid* userptr, ALvoid* sampledata, ALsizei numbytes) noexcept
+{
+  CallbackSoundSource& self = *static_cast<CallbackSoundSource*>(userptr);
+  return self.on_buffer_request(sampledata, numbytes);
+}
+
+ALsizei
+CallbackSoundSource::on_buffer_request(void* sampledata, ALsizei numbytes)
+{
+  size_t const len = m_reader->read(sampledata, static_cast<size_t>(numbytes));
+  m_samples_consumed += static_cast<int64_t>(len / m_reader->get_format().sample2bytes(1));
+
+  if (len < static_cast<size_t>(numbytes) && !m_reader->eof())
+  {
+    // returning less than requested would end the stream, so cover
+    // the decoder falling behind with silence
+    int const silence = (m_reader->get_format().get_bits_per_sample() == 8) ? 0x80 : 0x00;
+    memset(static_cast<char*>(sampledata) + len, silence, static_cast<size_t>(numbytes) - len);
+    m_underruns += 1;
+    return numbytes;
+  }
+
+  return static_cast<ALsizei>(len);
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,115 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_CALLBACK_SOUND_SOURCE_HPP
+#define HEADER_WSTSOUND_CALLBACK_SOUND_SOURCE_HPP
+
+#include <atomic>
+#include <memory>
+
+#include "decode_worker.hpp"
+#include "openal_sound_source.hpp"
+#include "stream_buffer_policy.hpp"
+#include "stream_reader.hpp"
+
+namespace wstsound {
+
+class SoundFile;
+class SoundChannel;
+
+/** A streaming source backed by AL_SOFT_callback_buffer, the OpenAL
+    mixer thread pulls decoded PCM straight out of the StreamReader's
+    ring buffer, so there is no buffer queue to maintain. The ring
+    buffer is filled by the DecodeWorker, or in update() if there is
+    none. */
+class CallbackSoundSource : public OpenALSoundSource
+{
+public:
+  static bool is_supported();
+
+public:
+  CallbackSoundSource(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file,
+                      DecodeWorkerPtr decode_worker = {},
+                      StreamBufferPolicy const& policy = {});
+  ~CallbackSoundSource() override;
+
+  void play() override;
+  void pause() override;
+  void preroll() override;
+  void finish() override;
+
+  SourceState get_state() const override { return m_state; }
+
+  void update(float delta) override;
+
+  void seek_to(double sec) override;
+  void seek_to_sample(int64_t sample) override;
+  void seek_to_sample_async(int64_t sample) override;
+
+  void set_looping(bool looping) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
+  void set_loop_crossfade(float duration) override;
+  void enqueue(std::unique_ptr<SoundFile> sound_file) override;
+
+  double get_pos() const override;
+  double get_duration() const override;
+
+  int64_t get_sample_pos() const override;
+  int64_t get_sample_duration() const override;
+
+  int64_t sec_to_sample(double sec) const override;
+  double sample_to_sec(int64_t sample) const override;
+
+private:
+  static ALsizei AL_APIENTRY cb_buffer(ALvoid* userptr, ALvoid* sampledata, ALsizei numbytes) noexcept;
+
+  /** Called from the OpenAL mixer thread */
+  ALsizei on_buffer_request(void* sampledata, ALsizei numbytes);
+
+  /** Stop the source, after this the mixer won't call back anymore */
+  void stop();
+
+  /** Rebase the position once playback passed into an enqueued file */
+  void update_transitions();
+
+private:
+  StreamReaderPtr m_reader;
+  DecodeWorkerPtr m_decode_worker;
+  ALuint m_buffer;
+  SourceState m_state;
+
+  /** Sample the playback was started or seeked from */
+  int64_t m_start_sample;
+  int64_t m_sample_duration;
+
+  /** Samples handed to the mixer since m_start_sample */
+  std::atomic<int64_t> m_samples_consumed;
+
+  /** Number of times the mixer asked for data the decoder didn't have */
+  std::atomic<int> m_underruns;
+
+public:
+  CallbackSoundSource(const CallbackSoundSource&) = delete;
+  CallbackSoundSource& operator=(const CallbackSoundSource&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -0,0 +1,117 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "decode_worker.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace wstsound {
+
+DecodeWorker::DecodeWorker(int num_threads) :
+  m_mutex(),
+  m_cond(),
+  m_quit(false),
+  m_pending(false),
+  m_readers(),
+  m_threads()
+{
+  for (int i = 0; i < num_threads; ++i) {
+    m_threads.emplace_back([this]{ run(); });
+  }
+}
+
+DecodeWorker::~DecodeWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_cond.notify_all();
+
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void
+DecodeWorker::add(StreamReaderPtr reader)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_readers.emplace_back(std::move(reader));
+    m_pending = true;
+  }
+  m_cond.notify_all();
+}
+
+void
+DecodeWorker::remove(StreamReaderPtr const& reader)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::erase(m_readers, reader);
+}
+
+void
+DecodeWorker::notify()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending = true;
+  }
+  m_cond.notify_one();
+}
+
+void
+DecodeWorker::run()
+{
+  std::vector<StreamReaderPtr> readers;
+
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_quit) { return; }
+
+      std::erase_if(m_readers, [](StreamReaderPtr const& reader){
+        return reader->is_cancelled();
+      });
+      readers = m_readers;
+    }
+
+    // round-robin one chunk per reader, so that a single busy stream
+    // can't starve the others
+    bool busy = false;
+    for (auto& reader : readers) {
+      busy |= reader->fill();
+    }
+    readers.clear();
+
+    if (!busy)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait_for(lock, std::chrono::milliseconds(10),
+                      [this]{ return m_quit || m_pending; });
+      m_pending = false;
+    }
+  }
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,71 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_DECODE_WORKER_HPP
+#define HEADER_WSTSOUND_DECODE_WORKER_HPP
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "stream_reader.hpp"
+
+namespace wstsound {
+
+/** DecodeWorker runs one or more background threads that keep the
+    ring buffers of all registered StreamReaders filled, so that the
+    game thread never has to wait on a codec. */
+class DecodeWorker
+{
+public:
+  DecodeWorker(int num_threads);
+  ~DecodeWorker();
+
+  void add(StreamReaderPtr reader);
+  void remove(StreamReaderPtr const& reader);
+
+  /** Wake up the worker threads, call after consuming data */
+  void notify();
+
+  int get_num_threads() const { return static_cast<int>(m_threads.size()); }
+
+private:
+  void run();
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_quit;
+  bool m_pending;
+  std::vector<StreamReaderPtr> m_readers;
+  std::vector<std::thread> m_threads;
+
+private:
+  DecodeWorker(const DecodeWorker&) = delete;
+  DecodeWorker& operator=(const DecodeWorker&) = delete;
+};
+
+using DecodeWorkerPtr = std::shared_ptr<DecodeWorker>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
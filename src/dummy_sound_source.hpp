@@ -19,6 +19,7 @@
 #ifndef HEADER_WINDSTILLE_SOUND_DUMMY_SOUND_SOURCE_HPP
 #define HEADER_WINDSTILLE_SOUND_DUMMY_SOUND_SOURCE_HPP
 
+#include "sound_file.hpp"
 #include "sound_source.hpp"
 
 namespace wstsound {
@@ -37,24 +38,26 @@ public:
 
   SourceState get_state() const override { return m_state; }
 
-  float get_duration() const override { return 0.0f; }
-  int get_sample_duration() const override { return 0; }
+  double get_duration() const override { return 0.0; }
+  int64_t get_sample_duration() const override { return 0; }
 
   void set_looping(bool looping) override {}
-  void set_loop(int sample_beg, int sample_end) override {}
+  void set_loop(int64_t sample_beg, int64_t sample_end) override {}
+  void enqueue(std::unique_ptr<SoundFile> sound_file) override {}
 
   /// Set volume (0.0 is silent, 1.0 is normal)
   void  set_gain(float gain) override {}
   float get_gain() const override { return 1.0f; }
+  void set_stem_gain(int stem, float gain) override {}
   void set_pitch(float pitch) override {}
 
-  void  seek_to(float sec) override {}
-  void  seek_to_sample(int sample) override {}
+  void  seek_to(double sec) override {}
+  void  seek_to_sample(int64_t sample) override {}
 
   /** Return the current position in seconds */
-  float get_pos() const override { return 0.0f; }
+  double get_pos() const override { return 0.0; }
 
-  int get_sample_pos() const override { return 0; }
+  int64_t get_sample_pos() const override { return 0; }
 
   void set_relative(bool relative) override {}
   void set_position(float x, float y, float z) override {}
@@ -79,11 +82,11 @@ public:
     m_state = SourceState::Finished;
   }
 
-  float sample_to_sec(int sample) const override {
-    return 0.0f;
+  double sample_to_sec(int64_t sample) const override {
+    return 0.0;
   }
 
-  int sec_to_sample(float sec) const override {
+  int64_t sec_to_sample(double sec) const override {
     return 0;
   }
 
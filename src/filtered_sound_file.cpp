@@ -63,7 +63,7 @@ FilteredSoundFile::get_format() const
 }
 
 void
-FilteredSoundFile::seek_to_sample(int sample)
+FilteredSoundFile::seek_to_sample(int64_t sample)
 {
   m_sound_file->seek_to_sample(sample);
 }
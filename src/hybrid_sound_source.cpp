@@ -0,0 +1,343 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hybrid_sound_source.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "openal_system.hpp"
+
+namespace wstsound {
+
+HybridSoundSource::HybridSoundSource(SoundChannel& channel, HybridHead const& head,
+                                     std::future<StreamReaderPtr> tail,
+                                     DecodeWorkerPtr decode_worker,
+                                     StreamBufferPolicy const& policy,
+                                     StreamBufferPoolPtr buffer_pool) :
+  OpenALSoundSource(channel),
+  m_head(head),
+  m_tail(std::move(tail)),
+  m_reader(),
+  m_decode_worker(std::move(decode_worker)),
+  m_buffer_pool(buffer_pool ? std::move(buffer_pool) : std::make_shared<StreamBufferPool>()),
+  m_al_format(head.format.get_openal_format()),
+  m_fragments(),
+  m_fragment_size(),
+  m_buffers(),
+  m_free_buffers(),
+  m_fragment(),
+  m_loop(),
+  m_seek(),
+  m_head_pending(true),
+  m_total_samples_processed(0),
+  m_state(SourceState::Paused)
+{
+  m_fragments = policy.get_fragments();
+  m_fragment_size = policy.get_fragment_size();
+
+  for(int i = 0; i < m_fragments; ++i) {
+    m_buffers.emplace_back(m_buffer_pool->acquire());
+  }
+}
+
+HybridSoundSource::~HybridSoundSource()
+{
+  if (m_reader && m_decode_worker) {
+    m_reader->cancel();
+    m_decode_worker->remove(m_reader);
+  }
+
+  clear_queue();
+
+  for(ALuint buffer : m_buffers) {
+    m_buffer_pool->release(buffer);
+  }
+}
+
+void
+HybridSoundSource::play()
+{
+  if (m_state == SourceState::Playing) { return; }
+
+  m_state = SourceState::Playing;
+
+  if (m_head_pending) {
+    queue_head();
+  }
+
+  update_queue();
+  OpenALSoundSource::play();
+}
+
+void
+HybridSoundSource::pause()
+{
+  if (m_state == SourceState::Paused) { return; }
+
+  m_state = SourceState::Paused;
+
+  OpenALSoundSource::pause();
+}
+
+void
+HybridSoundSource::finish()
+{
+  if (m_state == SourceState::Finished) { return; }
+
+  m_state = SourceState::Finished;
+
+  clear_queue();
+  OpenALSoundSource::finish();
+}
+
+void
+HybridSoundSource::update(float delta)
+{
+  OpenALSoundSource::update(delta);
+
+  if (m_state != SourceState::Playing) { return; }
+
+  update_queue();
+
+  ALint queued = 0;
+  alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+  if (queued == 0)
+  {
+    // a tail that failed to open counts as the end
+    if (m_reader ? m_reader->eof() : !m_tail.valid()) {
+      m_state = SourceState::Finished;
+      OpenALSoundSource::finish();
+    }
+  }
+  else
+  {
+    ALint state = AL_STOPPED;
+    alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING) {
+      if (m_total_samples_processed > 0) {
+        std::cerr << "Restarting audio source because of buffer underrun.\n";
+      }
+      OpenALSoundSource::play();
+    }
+  }
+}
+
+void
+HybridSoundSource::poll_tail()
+{
+  if (m_reader || !m_tail.valid() ||
+      m_tail.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+
+  try {
+    m_reader = m_tail.get();
+  } catch(std::exception const& err) {
+    std::cerr << "HybridSoundSource: Couldn't open tail: " << err.what() << std::endl;
+    return;
+  }
+
+  if (m_seek) {
+    m_reader->seek_to_sample(*m_seek);
+    m_seek = std::nullopt;
+  }
+
+  if (m_loop) {
+    m_reader->set_loop(m_loop);
+  }
+
+  if (m_decode_worker) {
+    m_decode_worker->add(m_reader);
+  }
+}
+
+void
+HybridSoundSource::update_queue()
+{
+  poll_tail();
+
+  ALint processed = 0;
+  alGetSourcei(m_source, AL_BUFFERS_PROCESSED, &processed);
+
+  std::vector<ALuint> unqueue_buffers(processed);
+  alSourceUnqueueBuffers(m_source, processed, unqueue_buffers.data());
+  OpenALSystem::warn_al_error("Couldn't unqueue audio buffer: ");
+
+  for(ALuint buffer : unqueue_buffers)
+  {
+    // the head buffer is shared and never refilled
+    if (buffer == m_head.buffer->get_handle()) {
+      m_total_samples_processed += m_head.sample_count;
+      continue;
+    }
+
+    ALint size = 0;
+    alGetBufferi(buffer, AL_SIZE, &size);
+    m_total_samples_processed += static_cast<int64_t>(static_cast<size_t>(size) / m_head.format.sample2bytes(1));
+    m_free_buffers.emplace_back(buffer);
+  }
+
+  if (!m_reader) { return; }
+
+  ALint queued = 0;
+  alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+  while (!m_free_buffers.empty())
+  {
+    if (m_reader->is_threaded() && !m_reader->ready(m_fragment_size)) {
+      if (queued > 0) { break; }
+      // nothing left to play, wait for the decoder here
+      m_reader->fill();
+    }
+
+    m_fragment.resize(m_fragment_size);
+    size_t const len = m_reader->read(m_fragment.data(), m_fragment.size());
+    if (len == 0) {
+      break;
+    }
+
+    ALuint const buffer = m_free_buffers.back();
+    alBufferData(buffer, m_al_format, m_fragment.data(), static_cast<ALsizei>(len),
+                 m_head.format.get_rate());
+    OpenALSystem::check_al_error("Couldn't refill audio buffer: ");
+
+    alSourceQueueBuffers(m_source, 1, &buffer);
+    OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+
+    m_free_buffers.pop_back();
+    queued += 1;
+  }
+
+  if (m_decode_worker) {
+    m_decode_worker->notify();
+  }
+}
+
+void
+HybridSoundSource::clear_queue()
+{
+  alSourceStop(m_source);
+  alSourcei(m_source, AL_BUFFER, AL_NONE);
+  m_free_buffers = m_buffers;
+}
+
+void
+HybridSoundSource::queue_head()
+{
+  m_head_pending = false;
+
+  ALuint const buffer = m_head.buffer->get_handle();
+  alSourceQueueBuffers(m_source, 1, &buffer);
+  OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+}
+
+void
+HybridSoundSource::seek_to(double sec)
+{
+  seek_to_sample(sec_to_sample(sec));
+}
+
+void
+HybridSoundSource::seek_to_sample(int64_t sample)
+{
+  clear_queue();
+  m_total_samples_processed = sample;
+  m_head_pending = false;
+
+  // restarting is the common case for one-shots, the head is still there
+  if (sample == 0) {
+    queue_head();
+    sample = m_head.sample_count;
+  }
+
+  if (m_reader) {
+    m_reader->seek_to_sample(sample);
+  } else {
+    m_seek = sample;
+  }
+
+  if (m_state == SourceState::Playing) {
+    update_queue();
+    OpenALSoundSource::play();
+  }
+}
+
+void
+HybridSoundSource::set_looping(bool looping)
+{
+  if (looping) {
+    set_loop(0, m_head.sample_duration);
+  } else {
+    m_loop = std::nullopt;
+    if (m_reader) {
+      m_reader->set_loop(std::nullopt);
+    }
+  }
+}
+
+void
+HybridSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
+{
+  if (sample_beg > sample_end) {
+    throw std::invalid_argument("HybridSoundSource::set_loop(): invalid loop range");
+  }
+
+  // the loop start is decoded from the file, the head only plays once
+  m_loop = StreamReader::Loop{sample_beg, sample_end};
+  if (m_reader) {
+    m_reader->set_loop(m_loop);
+  }
+}
+
+double
+HybridSoundSource::get_duration() const
+{
+  return sample_to_sec(m_head.sample_duration);
+}
+
+double
+HybridSoundSource::get_pos() const
+{
+  return sample_to_sec(get_sample_pos());
+}
+
+int64_t
+HybridSoundSource::get_sample_pos() const
+{
+  ALint sample_offset = 0;
+  alGetSourcei(m_source, AL_SAMPLE_OFFSET, &sample_offset);
+
+  return m_total_samples_processed + sample_offset;
+}
+
+int64_t
+HybridSoundSource::sec_to_sample(double sec) const
+{
+  return static_cast<int64_t>(sec * static_cast<double>(m_head.format.get_rate()));
+}
+
+double
+HybridSoundSource::sample_to_sec(int64_t sample) const
+{
+  return static_cast<double>(sample) / static_cast<double>(m_head.format.get_rate());
+}
+
+} // namespace wstsound
+
+/* EOF */
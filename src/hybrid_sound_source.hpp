@@ -0,0 +1,130 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_HYBRID_SOUND_SOURCE_HPP
+#define HEADER_WSTSOUND_HYBRID_SOUND_SOURCE_HPP
+
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "decode_worker.hpp"
+#include "openal_buffer.hpp"
+#include "openal_sound_source.hpp"
+#include "sound_format.hpp"
+#include "stream_buffer_policy.hpp"
+#include "stream_buffer_pool.hpp"
+#include "stream_reader.hpp"
+
+namespace wstsound {
+
+/** The decoded start of a file, shared by all sources playing it */
+struct HybridHead
+{
+  OpenALBufferPtr buffer;
+  SoundFormat format;
+  int64_t sample_count;
+  int64_t sample_duration;
+};
+
+/** Plays the cached start of a file from a static buffer and streams
+    the rest. The tail decoder is opened in the background while the
+    head plays, its fragments are queued behind the head buffer on the
+    same AL source, so the handover is sample-accurate. */
+class HybridSoundSource : public OpenALSoundSource
+{
+public:
+  /** Length of the head that gets cached */
+  static constexpr int HEAD_MSEC = 250;
+
+public:
+  /** 'tail' delivers a reader positioned at the end of the head,
+      'policy' has to be fixed, see StreamBufferPolicy::get_fixed() */
+  HybridSoundSource(SoundChannel& channel, HybridHead const& head,
+                    std::future<StreamReaderPtr> tail,
+                    DecodeWorkerPtr decode_worker = {},
+                    StreamBufferPolicy const& policy = {},
+                    StreamBufferPoolPtr buffer_pool = {});
+  ~HybridSoundSource() override;
+
+  void play() override;
+  void pause() override;
+  void finish() override;
+
+  SourceState get_state() const override { return m_state; }
+
+  void update(float delta) override;
+
+  /** Seeking back to 0 plays the head again, other positions wait
+      for the tail decoder */
+  void seek_to(double sec) override;
+  void seek_to_sample(int64_t sample) override;
+
+  void set_looping(bool looping) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
+
+  double get_duration() const override;
+  int64_t get_sample_duration() const override { return m_head.sample_duration; }
+
+  double get_pos() const override;
+  int64_t get_sample_pos() const override;
+
+  int64_t sec_to_sample(double sec) const override;
+  double sample_to_sec(int64_t sample) const override;
+
+private:
+  /** Take over the tail reader once it is open */
+  void poll_tail();
+  void update_queue();
+  void clear_queue();
+  void queue_head();
+
+private:
+  HybridHead m_head;
+  std::future<StreamReaderPtr> m_tail;
+  StreamReaderPtr m_reader;
+  DecodeWorkerPtr m_decode_worker;
+  StreamBufferPoolPtr m_buffer_pool;
+  ALenum m_al_format;
+  int m_fragments;
+  size_t m_fragment_size;
+  std::vector<ALuint> m_buffers;
+  std::vector<ALuint> m_free_buffers;
+  std::vector<char> m_fragment;
+
+  /** Loop and seek requested before the tail was open */
+  std::optional<StreamReader::Loop> m_loop;
+  std::optional<int64_t> m_seek;
+
+  /** The head still has to be queued by play() */
+  bool m_head_pending;
+
+  int64_t m_total_samples_processed;
+  SourceState m_state;
+
+private:
+  HybridSoundSource(const HybridSoundSource&) = delete;
+  HybridSoundSource& operator=(const HybridSoundSource&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -0,0 +1,379 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "loading_sound_source.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "sound_file.hpp"
+#include "stream_buffer_policy.hpp"
+
+namespace wstsound {
+
+LoadingSoundSource::LoadingSoundSource(std::future<std::unique_ptr<SoundFile>> sound_file,
+                                       CreateFunc create_func) :
+  LoadingSoundSource(std::shared_future<void>(), {})
+{
+  // std::function needs something copyable
+  auto future = std::make_shared<std::future<std::unique_ptr<SoundFile>>>(std::move(sound_file));
+  m_is_ready = [future]{
+    return future->wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  };
+  m_create_func = [future, create_func = std::move(create_func)]{
+    return create_func(future->get());
+  };
+}
+
+LoadingSoundSource::LoadingSoundSource(std::shared_future<void> ready,
+                                       std::function<SoundSourcePtr ()> create_func) :
+  m_is_ready([ready]{
+    return ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }),
+  m_create_func(std::move(create_func)),
+  m_source(),
+  m_pending(),
+  m_state(SourceState::Loading),
+  m_gain(1.0f),
+  m_max_latency(),
+  m_playing(false),
+  m_looping(false),
+  m_pitch(1.0f),
+  m_elapsed(0.0)
+{
+}
+
+LoadingSoundSource::~LoadingSoundSource()
+{
+  // the future comes from a packaged_task run by post_task() or a
+  // PreloadJob, not std::async, so dropping it doesn't block here
+}
+
+void
+LoadingSoundSource::forward(std::function<void (SoundSource&)> func)
+{
+  if (m_source) {
+    func(*m_source);
+  } else if (m_state == SourceState::Loading) {
+    m_pending.emplace_back(std::move(func));
+  }
+}
+
+void
+LoadingSoundSource::play()
+{
+  if (!m_source) {
+    m_playing = true;
+  }
+  forward([](SoundSource& source) { source.play(); });
+}
+
+void
+LoadingSoundSource::pause()
+{
+  if (!m_source) {
+    m_playing = false;
+  }
+  forward([](SoundSource& source) { source.pause(); });
+}
+
+void
+LoadingSoundSource::finish()
+{
+  if (m_source) {
+    m_source->finish();
+  } else {
+    // whatever gets loaded is thrown away
+    m_state = SourceState::Finished;
+    m_pending.clear();
+  }
+}
+
+void
+LoadingSoundSource::preroll()
+{
+  forward([](SoundSource& source) { source.preroll(); });
+}
+
+SourceState
+LoadingSoundSource::get_state() const
+{
+  return m_source ? m_source->get_state() : m_state;
+}
+
+double
+LoadingSoundSource::get_duration() const
+{
+  return m_source ? m_source->get_duration() : 0.0;
+}
+
+int64_t
+LoadingSoundSource::get_sample_duration() const
+{
+  return m_source ? m_source->get_sample_duration() : 0;
+}
+
+void
+LoadingSoundSource::set_fading(FadeDirection direction, float duration, FadeCurve curve)
+{
+  if (!m_source) {
+    // keep get_fade() consistent while loading
+    m_fade = Fade{direction, duration, 0.0f, curve};
+  }
+
+  forward([direction, duration, curve](SoundSource& source) { source.set_fading(direction, duration, curve); });
+}
+
+std::optional<SoundSource::Fade> const&
+LoadingSoundSource::get_fade() const
+{
+  return m_source ? m_source->get_fade() : m_fade;
+}
+
+void
+LoadingSoundSource::set_looping(bool looping)
+{
+  m_looping = looping;
+  forward([looping](SoundSource& source) { source.set_looping(looping); });
+}
+
+void
+LoadingSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
+{
+  forward([sample_beg, sample_end](SoundSource& source) { source.set_loop(sample_beg, sample_end); });
+}
+
+void
+LoadingSoundSource::set_loop_crossfade(float duration)
+{
+  forward([duration](SoundSource& source) { source.set_loop_crossfade(duration); });
+}
+
+void
+LoadingSoundSource::enqueue(std::unique_ptr<SoundFile> sound_file)
+{
+  // std::function needs something copyable
+  auto holder = std::make_shared<std::unique_ptr<SoundFile>>(std::move(sound_file));
+  forward([holder](SoundSource& source) { source.enqueue(std::move(*holder)); });
+}
+
+void
+LoadingSoundSource::set_gain(float gain)
+{
+  m_gain = gain;
+  forward([gain](SoundSource& source) { source.set_gain(gain); });
+}
+
+float
+LoadingSoundSource::get_gain() const
+{
+  return m_source ? m_source->get_gain() : m_gain;
+}
+
+void
+LoadingSoundSource::set_stem_gain(int stem, float gain)
+{
+  forward([stem, gain](SoundSource& source) { source.set_stem_gain(stem, gain); });
+}
+
+void
+LoadingSoundSource::set_pitch(float pitch)
+{
+  m_pitch = pitch;
+  forward([pitch](SoundSource& source) { source.set_pitch(pitch); });
+}
+
+void
+LoadingSoundSource::set_buffer_policy(StreamBufferPolicy const& policy)
+{
+  forward([policy](SoundSource& source) { source.set_buffer_policy(policy); });
+}
+
+void
+LoadingSoundSource::seek_to_sample(int64_t sample)
+{
+  // catch_up() starts from the seek position
+  m_elapsed = 0.0;
+  forward([sample](SoundSource& source) { source.seek_to_sample(sample); });
+}
+
+void
+LoadingSoundSource::seek_to(double sec)
+{
+  m_elapsed = 0.0;
+  forward([sec](SoundSource& source) { source.seek_to(sec); });
+}
+
+void
+LoadingSoundSource::seek_to_sample_async(int64_t sample)
+{
+  m_elapsed = 0.0;
+  forward([sample](SoundSource& source) { source.seek_to_sample_async(sample); });
+}
+
+double
+LoadingSoundSource::get_pos() const
+{
+  return m_source ? m_source->get_pos() : 0.0;
+}
+
+int64_t
+LoadingSoundSource::get_sample_pos() const
+{
+  return m_source ? m_source->get_sample_pos() : 0;
+}
+
+void
+LoadingSoundSource::set_relative(bool relative)
+{
+  forward([relative](SoundSource& source) { source.set_relative(relative); });
+}
+
+void
+LoadingSoundSource::set_position(float x, float y, float z)
+{
+  forward([x, y, z](SoundSource& source) { source.set_position(x, y, z); });
+}
+
+void
+LoadingSoundSource::set_velocity(float x, float y, float z)
+{
+  forward([x, y, z](SoundSource& source) { source.set_velocity(x, y, z); });
+}
+
+void
+LoadingSoundSource::set_reference_distance(float distance)
+{
+  forward([distance](SoundSource& source) { source.set_reference_distance(distance); });
+}
+
+void
+LoadingSoundSource::set_rolloff_factor(float factor)
+{
+  forward([factor](SoundSource& source) { source.set_rolloff_factor(factor); });
+}
+
+void
+LoadingSoundSource::set_direct_filter(FilterPtr const& filter)
+{
+  forward([filter](SoundSource& source) { source.set_direct_filter(filter); });
+}
+
+void
+LoadingSoundSource::set_effect_slot(EffectSlotPtr const& slot, FilterPtr const& filter)
+{
+  forward([slot, filter](SoundSource& source) { source.set_effect_slot(slot, filter); });
+}
+
+void
+LoadingSoundSource::update_gain() const
+{
+  // the real source picks up the channel gain when it gets created
+  if (m_source) {
+    m_source->update_gain();
+  }
+}
+
+void
+LoadingSoundSource::update(float delta)
+{
+  if (!m_source && m_state == SourceState::Loading && m_playing) {
+    m_elapsed += delta * m_pitch;
+  }
+
+  if (!m_source && m_state == SourceState::Loading && m_is_ready())
+  {
+    try
+    {
+      m_source = m_create_func();
+      m_source->update_gain();
+    }
+    catch(std::exception const& err)
+    {
+      std::cerr << "LoadingSoundSource: Couldn't load sound: " << err.what() << std::endl;
+      m_state = SourceState::Finished;
+      m_pending.clear();
+      return;
+    }
+
+    for(auto& func : m_pending) {
+      try {
+        func(*m_source);
+      } catch(std::exception const& err) {
+        std::cerr << "LoadingSoundSource: " << err.what() << std::endl;
+      }
+    }
+    m_pending.clear();
+
+    if (m_max_latency) {
+      catch_up();
+    }
+  }
+
+  if (m_source) {
+    m_source->update(delta);
+  }
+}
+
+void
+LoadingSoundSource::catch_up()
+{
+  if (!m_playing || m_elapsed <= 0.0) {
+    return;
+  }
+
+  if (m_elapsed > *m_max_latency && !m_looping) {
+    // too late to still make sense
+    m_source->finish();
+    return;
+  }
+
+  double const duration = m_source->get_duration();
+  double pos = m_source->get_pos() + m_elapsed;
+  if (duration > 0.0) {
+    if (m_looping) {
+      pos = std::fmod(pos, duration);
+    } else if (pos >= duration) {
+      m_source->finish();
+      return;
+    }
+  }
+
+  try {
+    m_source->seek_to(pos);
+  } catch(std::exception const& err) {
+    std::cerr << "LoadingSoundSource: " << err.what() << std::endl;
+  }
+}
+
+int64_t
+LoadingSoundSource::sec_to_sample(double sec) const
+{
+  return m_source ? m_source->sec_to_sample(sec) : 0;
+}
+
+double
+LoadingSoundSource::sample_to_sec(int64_t sample) const
+{
+  return m_source ? m_source->sample_to_sec(sample) : 0.0;
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,142 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_LOADING_SOUND_SOURCE_HPP
+#define HEADER_WSTSOUND_LOADING_SOUND_SOURCE_HPP
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "sound_source.hpp"
+
+namespace wstsound {
+
+class SoundFile;
+
+/** Stands in for a source whose SoundFile is still being opened on
+    another thread. Reports SourceState::Loading till then, calls
+    made in the meantime are recorded and replayed on the real source
+    once it got created in update(), everything after that is passed
+    through.
+
+    With a max latency set, the time the source would have been
+    playing while loading is skipped once it is ready, so it ends up
+    in sync with the game. If that is more than the max latency, a
+    non-looping source is dropped instead. */
+class LoadingSoundSource : public SoundSource
+{
+public:
+  using CreateFunc = std::function<SoundSourcePtr (std::unique_ptr<SoundFile>)>;
+
+public:
+  LoadingSoundSource(std::future<std::unique_ptr<SoundFile>> sound_file, CreateFunc create_func);
+
+  /** Calls 'create_func' once 'ready' is ready, e.g. for a buffer
+      that is loaded by SoundManager::preload_async() */
+  LoadingSoundSource(std::shared_future<void> ready, std::function<SoundSourcePtr ()> create_func);
+  ~LoadingSoundSource() override;
+
+  /** Catch up with the time spent loading, see above */
+  void set_max_latency(float max_latency) { m_max_latency = max_latency; }
+
+  void play() override;
+  void pause() override;
+  void finish() override;
+  void preroll() override;
+
+  SourceState get_state() const override;
+
+  /** Duration and sample conversions need the SoundFile and are 0
+      while loading */
+  double get_duration() const override;
+  int64_t get_sample_duration() const override;
+
+  void set_fading(FadeDirection direction, float duration,
+                  FadeCurve curve = FadeCurve::Linear) override;
+  std::optional<Fade> const& get_fade() const override;
+
+  void set_looping(bool looping) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
+  void set_loop_crossfade(float duration) override;
+  void enqueue(std::unique_ptr<SoundFile> sound_file) override;
+
+  void  set_gain(float gain) override;
+  float get_gain() const override;
+  void set_stem_gain(int stem, float gain) override;
+  void set_pitch(float pitch) override;
+  void set_buffer_policy(StreamBufferPolicy const& policy) override;
+
+  void seek_to_sample(int64_t sample) override;
+  void seek_to(double sec) override;
+  void seek_to_sample_async(int64_t sample) override;
+
+  double get_pos() const override;
+  int64_t get_sample_pos() const override;
+
+  void set_relative(bool relative) override;
+  void set_position(float x, float y, float z) override;
+  void set_velocity(float x, float y, float z) override;
+  void set_reference_distance(float distance) override;
+  void set_rolloff_factor(float factor) override;
+
+  void set_direct_filter(FilterPtr const& filter) override;
+  void set_effect_slot(EffectSlotPtr const& slot, FilterPtr const& filter = {}) override;
+
+  void update_gain() const override;
+  void update(float delta) override;
+
+  int64_t sec_to_sample(double sec) const override;
+  double sample_to_sec(int64_t sample) const override;
+
+private:
+  /** Call 'func' on the real source, or once it is there */
+  void forward(std::function<void (SoundSource&)> func);
+
+  /** Skip what should have been played while loading */
+  void catch_up();
+
+private:
+  std::function<bool ()> m_is_ready;
+  std::function<SoundSourcePtr ()> m_create_func;
+  SoundSourcePtr m_source;
+  std::vector<std::function<void (SoundSource&)>> m_pending;
+
+  /** Loading or Finished while there is no m_source */
+  SourceState m_state;
+  float m_gain;
+
+  std::optional<float> m_max_latency;
+  bool m_playing;
+  bool m_looping;
+  float m_pitch;
+
+  /** Seconds of the sound that passed since play() while loading */
+  double m_elapsed;
+
+private:
+  LoadingSoundSource(const LoadingSoundSource&) = delete;
+  LoadingSoundSource& operator=(const LoadingSoundSource&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
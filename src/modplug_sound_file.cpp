@@ -67,18 +67,18 @@ ModplugSoundFile::tell() const
 }
 
 void
-ModplugSoundFile::seek_to_sample(int sample)
+ModplugSoundFile::seek_to_sample(int64_t sample)
 {
   m_bytes_read = m_format.sample2bytes(sample);
-  long int msec = (1000L * static_cast<long>(sample) / static_cast<long>(m_format.get_rate()));
+  int64_t const msec = 1000 * sample / m_format.get_rate();
   ModPlug_Seek(m_file, static_cast<int>(msec));
 }
 
 size_t
 ModplugSoundFile::get_size() const
 {
-  long int duration_msec = ModPlug_GetLength(m_file);
-  return duration_msec * m_format.get_rate() * m_format.get_channels() * m_format.get_bits_per_sample() / 8  / 1000;
+  int64_t const duration_msec = ModPlug_GetLength(m_file);
+  return m_format.sample2bytes(duration_msec * m_format.get_rate() / 1000);
 }
 
 } // namespace wstsound
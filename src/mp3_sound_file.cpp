@@ -108,11 +108,11 @@ MP3SoundFile::read(void* buffer, size_t buffer_size)
 size_t
 MP3SoundFile::tell() const
 {
-  return m_format.sample2bytes(static_cast<int>(mpg123_tell(m_mh)));
+  return m_format.sample2bytes(mpg123_tell(m_mh));
 }
 
 void
-MP3SoundFile::seek_to_sample(int sample)
+MP3SoundFile::seek_to_sample(int64_t sample)
 {
   if (mpg123_seek(m_mh, sample, SEEK_SET) < 0) {
     throw SoundError("mpg123_seek() failed");
@@ -126,7 +126,7 @@ MP3SoundFile::get_size() const
   if (samples_len < 0) {
     return 0;
   }  else {
-    return m_format.sample2bytes(static_cast<int>(samples_len));
+    return m_format.sample2bytes(samples_len);
   }
 }
 
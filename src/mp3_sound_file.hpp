@@ -34,7 +34,7 @@ public:
 
   size_t read(void* buffer, size_t buffer_size) override;
   size_t tell() const override;
-  void seek_to_sample(int sample) override;
+  void seek_to_sample(int64_t sample) override;
   SoundFormat get_format() const override { return m_format; }
   size_t get_size() const override;
 
@@ -121,7 +121,7 @@ OggSoundFile::tell() const
 }
 
 void
-OggSoundFile::seek_to_sample(int sample)
+OggSoundFile::seek_to_sample(int64_t sample)
 {
   ov_pcm_seek_lap(&m_vorbis_file, sample);
 }
@@ -0,0 +1,96 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "openal_buffer.hpp"
+
+#include "sound_error.hpp"
+
+#ifndef AL_MAP_WRITE_BIT_SOFT
+#  define AL_MAP_WRITE_BIT_SOFT 0x00000002
+#endif
+
+namespace wstsound {
+
+namespace {
+
+/** AL_SOFT_map_buffer, looked up at runtime as older headers and
+    libraries don't have it */
+struct MapBufferFuncs
+{
+  void (AL_APIENTRY* buffer_storage)(ALuint buffer, ALenum format, const ALvoid* data,
+                                     ALsizei size, ALsizei freq, ALuint flags);
+  void* (AL_APIENTRY* map_buffer)(ALuint buffer, ALsizei offset, ALsizei length, ALuint access);
+  void (AL_APIENTRY* unmap_buffer)(ALuint buffer);
+};
+
+MapBufferFuncs const&
+get_map_buffer_funcs()
+{
+  static MapBufferFuncs const funcs = []{
+    MapBufferFuncs result{nullptr, nullptr, nullptr};
+    result.buffer_storage = reinterpret_cast<decltype(result.buffer_storage)>(alGetProcAddress("alBufferStorageSOFT"));
+    result.map_buffer = reinterpret_cast<decltype(result.map_buffer)>(alGetProcAddress("alMapBufferSOFT"));
+    result.unmap_buffer = reinterpret_cast<decltype(result.unmap_buffer)>(alGetProcAddress("alUnmapBufferSOFT"));
+    return result;
+  }();
+  return funcs;
+}
+
+} // namespace
+
+bool
+OpenALBuffer::is_map_supported()
+{
+  if (alIsExtensionPresent("AL_SOFT_map_buffer") != AL_TRUE &&
+      alIsExtensionPresent("AL_SOFTX_map_buffer") != AL_TRUE) {
+    return false;
+  }
+
+  MapBufferFuncs const& funcs = get_map_buffer_funcs();
+  return funcs.buffer_storage && funcs.map_buffer && funcs.unmap_buffer;
+}
+
+void
+OpenALBuffer::set_storage(ALenum format, ALsizei size, ALsizei freq)
+{
+  if (!is_map_supported()) {
+    throw SoundError("Couldn't allocate audio buffer storage: AL_SOFT_map_buffer not supported");
+  }
+
+  get_map_buffer_funcs().buffer_storage(m_handle, format, nullptr, size, freq, AL_MAP_WRITE_BIT_SOFT);
+  OpenALSystem::check_al_error("Couldn't allocate audio buffer storage: ");
+}
+
+void*
+OpenALBuffer::map(ALsizei size)
+{
+  void* data = get_map_buffer_funcs().map_buffer(m_handle, 0, size, AL_MAP_WRITE_BIT_SOFT);
+  OpenALSystem::check_al_error("Couldn't map audio buffer: ");
+  return data;
+}
+
+void
+OpenALBuffer::unmap()
+{
+  get_map_buffer_funcs().unmap_buffer(m_handle);
+  OpenALSystem::check_al_error("Couldn't unmap audio buffer: ");
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -18,8 +18,10 @@
 #define HEADER_WSTSOUND_OPENAL_BUFFER_HPP
 
 #include <memory>
+#include <stdint.h>
 
 #include <al.h>
+#include <alext.h>
 
 #include <wstsound/openal_system.hpp>
 
@@ -56,6 +58,38 @@ public:
     return m_handle;
   }
 
+  /** Whether set_storage() and map() are available, i.e.
+      AL_SOFT_map_buffer or its experimental AL_SOFTX_map_buffer */
+  static bool is_map_supported();
+
+  /** Requires AL_SOFT_map_buffer. Allocate 'size' bytes of sample
+      data that get written through map(). */
+  void set_storage(ALenum format, ALsizei size, ALsizei freq);
+
+  /** Map the first 'size' bytes for writing, the buffer can't be
+      played till unmap() */
+  void* map(ALsizei size);
+
+  void unmap();
+
+  /** Requires AL_SOFT_loop_points, the buffer must not be attached
+      to any source. Buffers are limited to ALint samples, so are the
+      points. */
+  void set_loop_points(int64_t sample_beg, int64_t sample_end)
+  {
+    ALint const points[2] = { static_cast<ALint>(sample_beg), static_cast<ALint>(sample_end) };
+    alBufferiv(m_handle, AL_LOOP_POINTS_SOFT, points);
+    OpenALSystem::check_al_error("Couldn't set audio buffer loop points: ");
+  }
+
+  /** Size of the sample data in bytes */
+  size_t get_size() const
+  {
+    ALint size = 0;
+    alGetBufferi(m_handle, AL_SIZE, &size);
+    return static_cast<size_t>(size);
+  }
+
   ALint get_frequency() const
   {
     ALint frequency;
@@ -63,7 +97,7 @@ public:
     return frequency;
   }
 
-  int get_sample_duration() const
+  int64_t get_sample_duration() const
   {
     ALint frequency;
     alGetBufferi(m_handle, AL_FREQUENCY, &frequency);
@@ -77,10 +111,10 @@ public:
     ALint size;
     alGetBufferi(m_handle, AL_SIZE, &size);
 
-    return 8 * size / channels / bits;
+    return 8 * static_cast<int64_t>(size) / channels / bits;
   }
 
-  float get_duration() const
+  double get_duration() const
   {
     ALint frequency;
     alGetBufferi(m_handle, AL_FREQUENCY, &frequency);
@@ -94,10 +128,10 @@ public:
     ALint size;
     alGetBufferi(m_handle, AL_SIZE, &size);
 
-    return static_cast<float>(size)
-      / static_cast<float>(frequency)
-      / static_cast<float>(channels)
-      / static_cast<float>(bits) * 8.0f;
+    return static_cast<double>(size)
+      / static_cast<double>(frequency)
+      / static_cast<double>(channels)
+      / static_cast<double>(bits) * 8.0;
   }
 
 public:
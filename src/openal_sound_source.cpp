@@ -103,20 +103,20 @@ OpenALSoundSource::get_state() const
 }
 
 void
-OpenALSoundSource::seek_to(float sec)
+OpenALSoundSource::seek_to(double sec)
 {
-  alSourcef(m_source, AL_SEC_OFFSET, sec);
+  alSourcef(m_source, AL_SEC_OFFSET, static_cast<ALfloat>(sec));
   OpenALSystem::warn_al_error("OpenALSoundSource::seek_to: ");
 }
 
 void
-OpenALSoundSource::seek_to_sample(int sample)
+OpenALSoundSource::seek_to_sample(int64_t sample)
 {
-  alSourcei(m_source, AL_SAMPLE_OFFSET, sample);
+  alSourcei(m_source, AL_SAMPLE_OFFSET, static_cast<ALint>(sample));
   OpenALSystem::warn_al_error("OpenALSoundSource::seek_to_sample: ");
 }
 
-float
+double
 OpenALSoundSource::get_pos() const
 {
   float sec = 0.0f;
@@ -125,7 +125,7 @@ OpenALSoundSource::get_pos() const
   return sec;
 }
 
-int
+int64_t
 OpenALSoundSource::get_sample_pos() const
 {
   ALint sample_pos;
@@ -142,7 +142,7 @@ OpenALSoundSource::set_looping(bool looping)
 }
 
 void
-OpenALSoundSource::set_loop(int sample_beg, int sample_end)
+OpenALSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
 {
   throw SoundError("OpenALSoundSource::set_loop() not supported for non-streaming sources");
 }
@@ -101,7 +101,7 @@ OpusSoundFile::tell() const
 }
 
 void
-OpusSoundFile::seek_to_sample(int sample)
+OpusSoundFile::seek_to_sample(int64_t sample)
 {
   op_pcm_seek(m_opus_file, sample);
 }
@@ -0,0 +1,299 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pcm_disk_cache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+#include "sound_error.hpp"
+
+namespace wstsound {
+
+namespace {
+
+char const MAGIC[8] = { 'W', 'S', 'T', 'P', 'C', 'M', '\0', '\1' };
+
+/** Header of an entry, the PCM follows right after it */
+struct Header
+{
+  char magic[8];
+  uint64_t path_hash;
+  uint64_t source_stamp;
+  uint64_t data_size;
+  uint64_t checksum;
+  int32_t rate;
+  int32_t channels;
+  int32_t bits_per_sample;
+  char padding[12];
+};
+
+static_assert(sizeof(Header) == 64, "Header must stay 64 bytes");
+
+/** FNV-1a */
+uint64_t
+hash_bytes(void const* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+  auto const* bytes = static_cast<unsigned char const*>(data);
+  for(size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+uint64_t
+hash_path(std::filesystem::path const& filename)
+{
+  std::string const str = filename.generic_string();
+  return hash_bytes(str.data(), str.size());
+}
+
+} // namespace
+
+PCMDiskCache::PCMDiskCache(std::filesystem::path directory, uint64_t max_bytes, OpenFunc open_func) :
+  m_directory(std::move(directory)),
+  m_max_bytes(max_bytes),
+  m_open_func(std::move(open_func)),
+  m_tmp_counter(0),
+  m_trim_mutex()
+{
+  std::error_code ec;
+  std::filesystem::create_directories(m_directory, ec);
+  if (ec) {
+    throw SoundError("PCMDiskCache: couldn't create " + m_directory.string() + ": " + ec.message());
+  }
+}
+
+std::filesystem::path
+PCMDiskCache::get_entry_path(std::filesystem::path const& filename) const
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.pcm", static_cast<unsigned long long>(hash_path(filename)));
+  return m_directory / name;
+}
+
+std::optional<uint64_t>
+PCMDiskCache::get_source_stamp(std::filesystem::path const& filename) const
+{
+  if (!m_open_func)
+  {
+    // SoundFile::from_file() reads straight from disk
+    std::error_code ec;
+    uint64_t const size = std::filesystem::file_size(filename, ec);
+    if (ec) { return std::nullopt; }
+
+    auto const mtime = std::filesystem::last_write_time(filename, ec);
+    if (ec) { return std::nullopt; }
+
+    int64_t const ticks = mtime.time_since_epoch().count();
+    return hash_bytes(&ticks, sizeof(ticks), hash_bytes(&size, sizeof(size)));
+  }
+  else
+  {
+    // the OpenFunc might read from an archive, so there is no mtime
+    std::unique_ptr<std::istream> in = m_open_func(filename);
+    if (!in) { return std::nullopt; }
+
+    uint64_t hash = hash_bytes(nullptr, 0);
+    char buffer[1024 * 64];
+    while (in->read(buffer, sizeof(buffer)) || in->gcount() > 0) {
+      hash = hash_bytes(buffer, static_cast<size_t>(in->gcount()), hash);
+    }
+    return hash;
+  }
+}
+
+bool
+PCMDiskCache::load(std::filesystem::path const& filename, SoundFormat& format, std::vector<char>& data)
+{
+  bool const hit = load(filename, [&format, &data](SoundFormat const& entry_format, size_t size) {
+    format = entry_format;
+    data.resize(size);
+    return data.data();
+  });
+
+  if (!hit) {
+    data.clear();
+  }
+  return hit;
+}
+
+bool
+PCMDiskCache::load(std::filesystem::path const& filename, MemoryFunc const& get_memory)
+{
+  std::filesystem::path const entry_path = get_entry_path(filename);
+
+  std::ifstream in(entry_path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+
+  Header header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.path_hash != hash_path(filename))
+  {
+    return false;
+  }
+
+  std::optional<uint64_t> const stamp = get_source_stamp(filename);
+  if (!stamp || *stamp != header.source_stamp) {
+    // stale, store() replaces it
+    return false;
+  }
+
+  size_t const size = static_cast<size_t>(header.data_size);
+  char* const data = get_memory(SoundFormat(header.rate, header.channels, header.bits_per_sample), size);
+  if (!data) {
+    return false;
+  }
+
+  // hash through a small buffer instead of reading back 'data',
+  // which might be write-only mapped AL memory
+  uint64_t checksum = hash_bytes(nullptr, 0);
+  char buffer[1024 * 64];
+  size_t total = 0;
+  while (total < size && in.read(buffer, static_cast<std::streamsize>(std::min(sizeof(buffer), size - total)))) {
+    size_t const len = static_cast<size_t>(in.gcount());
+    checksum = hash_bytes(buffer, len, checksum);
+    memcpy(data + total, buffer, len);
+    total += len;
+  }
+
+  if (total != size || checksum != header.checksum)
+  {
+    std::cerr << "PCMDiskCache: removing damaged entry " << entry_path << std::endl;
+    in.close();
+    std::error_code ec;
+    std::filesystem::remove(entry_path, ec);
+    return false;
+  }
+
+  // last_write_time serves as the last use for trim()
+  std::error_code ec;
+  std::filesystem::last_write_time(entry_path, std::filesystem::file_time_type::clock::now(), ec);
+
+  return true;
+}
+
+void
+PCMDiskCache::store(std::filesystem::path const& filename, SoundFormat const& format,
+                    char const* data, size_t size)
+{
+  std::optional<uint64_t> const stamp = get_source_stamp(filename);
+  if (!stamp) {
+    return;
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.path_hash = hash_path(filename);
+  header.source_stamp = *stamp;
+  header.data_size = size;
+  header.checksum = hash_bytes(data, size);
+  header.rate = format.get_rate();
+  header.channels = format.get_channels();
+  header.bits_per_sample = format.get_bits_per_sample();
+
+  // write to a temporary file first, so a crash or a concurrent
+  // store() never leaves a partial entry behind
+  std::filesystem::path const entry_path = get_entry_path(filename);
+  std::filesystem::path tmp_path = entry_path;
+  tmp_path += "." + std::to_string(m_tmp_counter++) + ".tmp";
+
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.write(data, static_cast<std::streamsize>(size));
+    if (!out) {
+      std::cerr << "PCMDiskCache: couldn't write " << tmp_path << std::endl;
+      out.close();
+      std::error_code ec;
+      std::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, entry_path, ec);
+  if (ec) {
+    std::cerr << "PCMDiskCache: couldn't write " << entry_path << ": " << ec.message() << std::endl;
+    std::filesystem::remove(tmp_path, ec);
+    return;
+  }
+
+  trim();
+}
+
+void
+PCMDiskCache::trim()
+{
+  if (m_max_bytes == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_trim_mutex);
+
+  struct Entry
+  {
+    std::filesystem::path path;
+    uint64_t size;
+    std::filesystem::file_time_type last_use;
+  };
+
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+
+  std::error_code ec;
+  for(auto const& dirent : std::filesystem::directory_iterator(m_directory, ec))
+  {
+    if (dirent.path().extension() != ".pcm") {
+      continue;
+    }
+
+    std::error_code entry_ec;
+    uint64_t const size = dirent.file_size(entry_ec);
+    auto const last_use = dirent.last_write_time(entry_ec);
+    if (!entry_ec) {
+      entries.emplace_back(Entry{dirent.path(), size, last_use});
+      total += size;
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](Entry const& lhs, Entry const& rhs) { return lhs.last_use < rhs.last_use; });
+
+  for(auto const& entry : entries) {
+    if (total <= m_max_bytes) {
+      break;
+    }
+
+    if (std::filesystem::remove(entry.path, ec)) {
+      total -= entry.size;
+    }
+  }
+}
+
+} // namespace wstsound
+
+/* EOF */
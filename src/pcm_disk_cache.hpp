@@ -0,0 +1,103 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_PCM_DISK_CACHE_HPP
+#define HEADER_WSTSOUND_PCM_DISK_CACHE_HPP
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+#include "sound_format.hpp"
+
+namespace wstsound {
+
+/** Directory of decoded files, so STATIC loads can skip the decoder
+    on later runs. Each entry is a 64 byte header followed by the raw
+    PCM, named after a hash of the source path. The header holds the
+    SoundFormat, a checksum of the PCM and a stamp of the source: its
+    size and modification time, or a hash of its content when files
+    are opened through an OpenFunc. There is no mtime behind an
+    OpenFunc, so then every load() and store() reads the whole source
+    once, which is still far cheaper than decoding it. Entries with a
+    stale stamp or a bad checksum are misses. Safe to use from
+    multiple threads. */
+class PCMDiskCache
+{
+public:
+  using OpenFunc = std::function<std::unique_ptr<std::istream> (std::filesystem::path)>;
+
+  /** Returns where 'size' bytes of PCM in 'format' go, nullptr to
+      skip the entry */
+  using MemoryFunc = std::function<char* (SoundFormat const& format, size_t size)>;
+
+public:
+  /** Keep at most 'max_bytes' in 'directory', 0 means no limit. The
+      directory is created if needed. */
+  PCMDiskCache(std::filesystem::path directory, uint64_t max_bytes, OpenFunc open_func);
+
+  /** Fill 'format' and 'data' with the cached PCM of 'filename',
+      false on a miss */
+  bool load(std::filesystem::path const& filename, SoundFormat& format, std::vector<char>& data);
+
+  /** Read the cached PCM of 'filename' into the memory returned by
+      'get_memory', which is only called for a valid entry. The
+      checksum is verified after reading, so on false the memory
+      might have been written to. */
+  bool load(std::filesystem::path const& filename, MemoryFunc const& get_memory);
+
+  /** Cache the PCM of 'filename', failures are only reported */
+  void store(std::filesystem::path const& filename, SoundFormat const& format,
+             char const* data, size_t size);
+
+  /** Remove the least recently used entries till the directory fits
+      max_bytes */
+  void trim();
+
+  std::filesystem::path const& get_directory() const { return m_directory; }
+
+private:
+  std::filesystem::path get_entry_path(std::filesystem::path const& filename) const;
+
+  /** Changes whenever the source file does, nullopt if it can't be
+      accessed */
+  std::optional<uint64_t> get_source_stamp(std::filesystem::path const& filename) const;
+
+private:
+  std::filesystem::path m_directory;
+  uint64_t m_max_bytes;
+  OpenFunc m_open_func;
+  std::atomic<uint64_t> m_tmp_counter;
+  std::mutex m_trim_mutex;
+
+private:
+  PCMDiskCache(const PCMDiskCache&) = delete;
+  PCMDiskCache& operator=(const PCMDiskCache&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -0,0 +1,56 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "preload_job.hpp"
+
+namespace wstsound {
+
+PreloadJob::PreloadJob(size_t total) :
+  m_total(total),
+  m_done(0),
+  m_cancelled(false),
+  m_finished(false),
+  m_promise(),
+  m_future(m_promise.get_future().share()),
+  m_mutex(),
+  m_outstanding(0),
+  m_decoded(),
+  m_errors()
+{
+}
+
+float
+PreloadJob::get_progress() const
+{
+  if (m_total == 0) {
+    return 1.0f;
+  }
+
+  return static_cast<float>(m_done) / static_cast<float>(m_total);
+}
+
+std::vector<std::pair<std::filesystem::path, std::string>>
+PreloadJob::get_errors() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_errors;
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -53,8 +53,8 @@ ProceduralSoundFile::read(void* buffer, size_t buffer_size)
 
   for(size_t i = 0; i < len; ++i) {
     size_t const pos = m_sample_pos + i;
-    float const pos_sec = static_cast<float>(pos) / static_cast<float>(m_format.get_rate());
-    float const value = sinf(pos_sec * 5000.0f);
+    double const pos_sec = static_cast<double>(pos) / static_cast<double>(m_format.get_rate());
+    float const value = static_cast<float>(sin(pos_sec * 5000.0));
     samples[i] = map_to<int16_t>(value);
     //samples[i] = static_cast<int16_t>(rand() % 30000) / 4 + map_to<int16_t>(value);
   }
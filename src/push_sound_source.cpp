@@ -0,0 +1,388 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "push_sound_source.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+
+#include "openal_system.hpp"
+#include "ring_buffer.hpp"
+#include "sound_error.hpp"
+
+namespace wstsound {
+
+namespace {
+
+// AL buffers kept queued, the rest of the latency is in the jitter buffer
+constexpr int QUEUE_FRAGMENTS = 3;
+
+} // namespace
+
+PushSoundSource::PushSoundSource(SoundChannel& channel, SoundFormat const& format,
+                                 JitterBufferConfig const& config) :
+  OpenALSoundSource(channel),
+  m_format(format),
+  m_al_format(format.get_openal_format()),
+  m_config(config),
+  m_ring(),
+  m_fragment_size(),
+  m_target_size(),
+  m_buffers(QUEUE_FRAGMENTS),
+  m_free_buffers(),
+  m_fragment(),
+  m_concealed(0),
+  m_buffering(true),
+  m_queued_samples(0),
+  m_total_samples_processed(0),
+  m_pitch(1.0f),
+  m_drift_ratio(1.0f),
+  m_buffered(0.0f),
+  m_min_buffered(0.0f),
+  m_max_buffered(0.0f),
+  m_underruns(0),
+  m_overruns(0),
+  m_state(SourceState::Paused)
+{
+  if (config.fragment_duration <= 0.0f ||
+      config.target_latency < config.fragment_duration ||
+      config.max_latency < config.target_latency + config.fragment_duration ||
+      config.max_drift_correction < 0.0f) {
+    throw std::invalid_argument("PushSoundSource: invalid JitterBufferConfig");
+  }
+
+  auto const sec_to_bytes = [&format](float sec) {
+    return format.sample2bytes(std::max(1, static_cast<int>(sec * static_cast<float>(format.get_rate()))));
+  };
+
+  m_fragment_size = sec_to_bytes(config.fragment_duration);
+  m_target_size = sec_to_bytes(config.target_latency);
+  m_ring = std::make_unique<RingBuffer>(sec_to_bytes(config.max_latency));
+
+  alGenBuffers(QUEUE_FRAGMENTS, m_buffers.data());
+  OpenALSystem::check_al_error("Couldn't allocate audio buffers: ");
+
+  m_free_buffers = m_buffers;
+}
+
+PushSoundSource::~PushSoundSource()
+{
+  alSourceStop(m_source);
+  alSourcei(m_source, AL_BUFFER, AL_NONE);
+  alDeleteBuffers(static_cast<ALsizei>(m_buffers.size()), m_buffers.data());
+  OpenALSystem::warn_al_error("Couldn't delete audio buffers: ");
+}
+
+size_t
+PushSoundSource::push(void const* data, size_t len)
+{
+  // only whole frames, so the consumer never gets out of step
+  size_t const frame_size = m_format.sample2bytes(1);
+  size_t const available = m_ring->write_available();
+  size_t const count = std::min(len - len % frame_size, available - available % frame_size);
+
+  if (count < len) {
+    m_overruns.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return m_ring->write(data, count);
+}
+
+PushSoundSource::Stats
+PushSoundSource::get_stats() const
+{
+  return Stats{
+    m_buffered,
+    m_min_buffered,
+    m_max_buffered,
+    m_drift_ratio,
+    m_underruns,
+    m_overruns.load(std::memory_order_relaxed)
+  };
+}
+
+void
+PushSoundSource::reset_stats()
+{
+  m_min_buffered = m_buffered;
+  m_max_buffered = m_buffered;
+  m_underruns = 0;
+  m_overruns.store(0, std::memory_order_relaxed);
+}
+
+void
+PushSoundSource::play()
+{
+  if (m_state == SourceState::Playing) { return; }
+
+  m_state = SourceState::Playing;
+
+  // a fresh source starts in update() once the target latency is reached
+  ALint queued = 0;
+  alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+  if (queued > 0) {
+    OpenALSoundSource::play();
+  }
+}
+
+void
+PushSoundSource::pause()
+{
+  if (m_state == SourceState::Paused) { return; }
+
+  m_state = SourceState::Paused;
+
+  OpenALSoundSource::pause();
+}
+
+void
+PushSoundSource::finish()
+{
+  if (m_state == SourceState::Finished) { return; }
+
+  m_state = SourceState::Finished;
+
+  OpenALSoundSource::finish();
+  alSourcei(m_source, AL_BUFFER, AL_NONE);
+  m_free_buffers = m_buffers;
+  m_queued_samples = 0;
+}
+
+void
+PushSoundSource::set_looping(bool looping)
+{
+  throw SoundError("PushSoundSource: looping not supported");
+}
+
+void
+PushSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
+{
+  throw SoundError("PushSoundSource: looping not supported");
+}
+
+void
+PushSoundSource::seek_to(double sec)
+{
+  throw SoundError("PushSoundSource: seeking not supported");
+}
+
+void
+PushSoundSource::seek_to_sample(int64_t sample)
+{
+  throw SoundError("PushSoundSource: seeking not supported");
+}
+
+void
+PushSoundSource::set_pitch(float pitch)
+{
+  m_pitch = pitch;
+  OpenALSoundSource::set_pitch(m_pitch * m_drift_ratio);
+}
+
+double
+PushSoundSource::get_pos() const
+{
+  return sample_to_sec(get_sample_pos());
+}
+
+int64_t
+PushSoundSource::get_sample_pos() const
+{
+  return m_total_samples_processed + OpenALSoundSource::get_sample_pos();
+}
+
+int64_t
+PushSoundSource::sec_to_sample(double sec) const
+{
+  return static_cast<int64_t>(sec * static_cast<double>(m_format.get_rate()));
+}
+
+double
+PushSoundSource::sample_to_sec(int64_t sample) const
+{
+  return static_cast<double>(sample) / static_cast<double>(m_format.get_rate());
+}
+
+void
+PushSoundSource::update(float delta)
+{
+  OpenALSoundSource::update(delta);
+
+  if (m_state != SourceState::Playing) { return; }
+
+  unqueue_buffers();
+
+  if (m_buffering && m_ring->read_available() >= m_target_size) {
+    m_buffering = false;
+  }
+
+  ALint queued = 0;
+  alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+
+  size_t const frame_size = m_format.sample2bytes(1);
+  while (!m_free_buffers.empty())
+  {
+    size_t const available = m_ring->read_available();
+    if (!m_buffering && available >= m_fragment_size) {
+      queue_fragment(m_fragment_size);
+    } else if (queued > 1) {
+      // enough left to wait for more data
+      break;
+    } else if (!m_buffering && available >= frame_size) {
+      // about to run dry, take what is there
+      queue_fragment(available - available % frame_size);
+    } else if (queued > 0 || m_total_samples_processed > 0) {
+      // keep the source going and build the buffer up again
+      conceal_fragment();
+      m_buffering = true;
+    } else {
+      // nothing played yet, nothing to conceal
+      break;
+    }
+
+    queued += 1;
+  }
+
+  if (queued > 0)
+  {
+    ALint state = AL_STOPPED;
+    alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING) {
+      OpenALSoundSource::play();
+    }
+  }
+
+  update_drift();
+}
+
+void
+PushSoundSource::unqueue_buffers()
+{
+  ALint processed = 0;
+  alGetSourcei(m_source, AL_BUFFERS_PROCESSED, &processed);
+  if (processed == 0) { return; }
+
+  std::vector<ALuint> buffers(processed);
+  alSourceUnqueueBuffers(m_source, processed, buffers.data());
+  OpenALSystem::warn_al_error("Couldn't unqueue audio buffer: ");
+
+  for(ALuint buffer : buffers) {
+    ALint size = 0;
+    alGetBufferi(buffer, AL_SIZE, &size);
+    int const samples = static_cast<int>(static_cast<size_t>(size) / m_format.sample2bytes(1));
+    m_total_samples_processed += samples;
+    m_queued_samples -= samples;
+
+    m_free_buffers.emplace_back(buffer);
+  }
+}
+
+void
+PushSoundSource::queue_fragment(size_t len)
+{
+  m_fragment.resize(len);
+  m_ring->read(m_fragment.data(), len);
+  m_concealed = 0;
+
+  ALuint const buffer = m_free_buffers.back();
+  alBufferData(buffer, m_al_format, m_fragment.data(), static_cast<ALsizei>(len), m_format.get_rate());
+  OpenALSystem::check_al_error("Couldn't refill audio buffer: ");
+
+  alSourceQueueBuffers(m_source, 1, &buffer);
+  OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+
+  m_free_buffers.pop_back();
+  m_queued_samples += static_cast<int64_t>(len / m_format.sample2bytes(1));
+}
+
+void
+PushSoundSource::conceal_fragment()
+{
+  m_underruns += 1;
+
+  if (m_concealed == 0 && m_format.get_bits_per_sample() == 16 && !m_fragment.empty())
+  {
+    // repeat the last fragment with a fade-out, which hides a short
+    // gap better than a hard cut to silence
+    int const channels = m_format.get_channels();
+    int const frames = static_cast<int>(m_fragment.size() / m_format.sample2bytes(1));
+    int16_t* const samples = reinterpret_cast<int16_t*>(m_fragment.data());
+    for(int i = 0; i < frames; ++i) {
+      for(int c = 0; c < channels; ++c) {
+        samples[i * channels + c] = static_cast<int16_t>(samples[i * channels + c] * (frames - i) / frames);
+      }
+    }
+  }
+  else
+  {
+    m_fragment.resize(m_fragment_size);
+    memset(m_fragment.data(), m_format.get_bits_per_sample() == 8 ? 128 : 0, m_fragment.size());
+  }
+  m_concealed += 1;
+
+  ALuint const buffer = m_free_buffers.back();
+  alBufferData(buffer, m_al_format, m_fragment.data(), static_cast<ALsizei>(m_fragment.size()),
+               m_format.get_rate());
+  OpenALSystem::check_al_error("Couldn't refill audio buffer: ");
+
+  alSourceQueueBuffers(m_source, 1, &buffer);
+  OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+
+  m_free_buffers.pop_back();
+  m_queued_samples += static_cast<int64_t>(m_fragment.size() / m_format.sample2bytes(1));
+}
+
+float
+PushSoundSource::get_buffered() const
+{
+  ALint sample_offset = 0;
+  alGetSourcei(m_source, AL_SAMPLE_OFFSET, &sample_offset);
+
+  float const rate = static_cast<float>(m_format.get_rate());
+  float const ring_samples = static_cast<float>(m_ring->read_available() / m_format.sample2bytes(1));
+  return (ring_samples + static_cast<float>(std::max<int64_t>(0, m_queued_samples - sample_offset))) / rate;
+}
+
+void
+PushSoundSource::update_drift()
+{
+  // smooth out the jitter, only the long term trend is clock drift
+  m_buffered += (get_buffered() - m_buffered) * 0.05f;
+  m_min_buffered = std::min(m_min_buffered, m_buffered);
+  m_max_buffered = std::max(m_max_buffered, m_buffered);
+
+  float ratio = 1.0f;
+  if (!m_buffering) {
+    float const error = (m_buffered - m_config.target_latency) / m_config.target_latency;
+    ratio = 1.0f + std::clamp(error * m_config.max_drift_correction,
+                              -m_config.max_drift_correction,
+                              m_config.max_drift_correction);
+  }
+
+  if (std::abs(ratio - m_drift_ratio) > 0.0001f) {
+    m_drift_ratio = ratio;
+    OpenALSoundSource::set_pitch(m_pitch * m_drift_ratio);
+  }
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,349 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "read_ahead_stream.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#include "sound_error.hpp"
+
+namespace wstsound {
+
+ReadAheadIO::ReadAheadIO() :
+  m_mutex(),
+  m_cond(),
+  m_streams(),
+  m_busy(nullptr),
+  m_pending(false),
+  m_quit(false),
+  m_thread()
+{
+}
+
+ReadAheadIO::~ReadAheadIO()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_cond.notify_all();
+
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void
+ReadAheadIO::add(ReadAheadStreambuf* stream)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_streams.emplace_back(stream);
+    m_pending = true;
+    if (!m_thread.joinable()) {
+      m_thread = std::thread([this]{ run(); });
+    }
+  }
+  m_cond.notify_all();
+}
+
+void
+ReadAheadIO::remove(ReadAheadStreambuf* stream)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  std::erase(m_streams, stream);
+  m_cond.wait(lock, [this, stream]{ return m_busy != stream; });
+}
+
+void
+ReadAheadIO::wake()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending = true;
+  }
+  m_cond.notify_all();
+}
+
+void
+ReadAheadIO::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_quit)
+  {
+    if (!m_pending) {
+      m_cond.wait(lock);
+      continue;
+    }
+    m_pending = false;
+
+    // one chunk per stream and pass, so a stream that just seeked
+    // doesn't wait for the whole window of every other one
+    for (size_t i = 0; i < m_streams.size(); ++i) {
+      ReadAheadStreambuf* stream = m_streams[i];
+      m_busy = stream;
+      lock.unlock();
+
+      bool const loaded = stream->load_next_chunk();
+
+      lock.lock();
+      m_busy = nullptr;
+      if (loaded) {
+        m_pending = true;
+      }
+      m_cond.notify_all();
+    }
+  }
+}
+
+ReadAheadStreambuf::ReadAheadStreambuf(std::unique_ptr<std::istream> source,
+                                       std::shared_ptr<ReadAheadIO> io,
+                                       size_t chunk_size, int chunks_ahead, int fd) :
+  m_source(std::move(source)),
+  m_io(std::move(io)),
+  m_chunk_size(chunk_size),
+  m_chunks_ahead(std::max(1, chunks_ahead)),
+  m_fd(fd),
+  m_size(0),
+  m_chunk(-1),
+  m_pos(0),
+  m_mutex(),
+  m_cond(),
+  m_chunks(),
+  m_read_chunk(0),
+  m_error(false)
+{
+  m_source->seekg(0, std::ios::end);
+  m_size = m_source->tellg();
+  m_source->seekg(0, std::ios::beg);
+
+  if (!*m_source || m_size < 0) {
+#ifdef __linux__
+    if (m_fd >= 0) { ::close(m_fd); }
+#endif
+    throw SoundError("ReadAheadStreambuf: source stream is not seekable");
+  }
+
+  setg(nullptr, nullptr, nullptr);
+
+  m_io->add(this);
+}
+
+ReadAheadStreambuf::~ReadAheadStreambuf()
+{
+  m_io->remove(this);
+
+#ifdef __linux__
+  if (m_fd >= 0) { ::close(m_fd); }
+#endif
+}
+
+ReadAheadStreambuf::off_type
+ReadAheadStreambuf::get_pos() const
+{
+  if (m_chunk < 0) {
+    return m_pos;
+  } else {
+    return m_chunk * static_cast<off_type>(m_chunk_size) + (gptr() - eback());
+  }
+}
+
+ReadAheadStreambuf::int_type
+ReadAheadStreambuf::underflow()
+{
+  off_type const pos = get_pos();
+  if (pos >= m_size) {
+    return traits_type::eof();
+  }
+
+  off_type const chunk = pos / static_cast<off_type>(m_chunk_size);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_read_chunk != chunk) {
+    m_read_chunk = chunk;
+    m_io->wake();
+  }
+
+  // only blocks when the worker hasn't gotten to this chunk yet
+  m_cond.wait(lock, [this, chunk]{ return m_error || m_chunks.contains(chunk); });
+
+  auto it = m_chunks.find(chunk);
+  off_type const offset = pos - chunk * static_cast<off_type>(m_chunk_size);
+  if (it == m_chunks.end() || offset >= static_cast<off_type>(it->second.size())) {
+    return traits_type::eof();
+  }
+
+  // chunks at or after m_read_chunk are never touched by the worker
+  std::vector<char>& data = it->second;
+  setg(data.data(), data.data() + offset, data.data() + data.size());
+  m_chunk = chunk;
+
+  return traits_type::to_int_type(*gptr());
+}
+
+ReadAheadStreambuf::pos_type
+ReadAheadStreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if (!(which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+
+  off_type base = 0;
+  if (dir == std::ios_base::cur) {
+    base = get_pos();
+  } else if (dir == std::ios_base::end) {
+    base = m_size;
+  }
+
+  off_type const pos = base + off;
+  if (pos < 0 || pos > m_size) {
+    return pos_type(off_type(-1));
+  }
+
+  off_type const chunk_beg = m_chunk * static_cast<off_type>(m_chunk_size);
+  if (m_chunk >= 0 && pos >= chunk_beg && pos < chunk_beg + (egptr() - eback())) {
+    // stay within the current chunk
+    setg(eback(), eback() + (pos - chunk_beg), egptr());
+  } else {
+    m_chunk = -1;
+    m_pos = pos;
+    setg(nullptr, nullptr, nullptr);
+
+    // like with a plain std::ifstream, a seek gives a failed read
+    // another try; nothing points into m_chunks anymore
+    bool retry = false;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_error) {
+        off_type const chunk_size = static_cast<off_type>(m_chunk_size);
+        std::erase_if(m_chunks, [this, chunk_size](auto const& it) {
+          return static_cast<off_type>(it.second.size()) < std::min(chunk_size, m_size - it.first * chunk_size);
+        });
+        m_error = false;
+        retry = true;
+      }
+    }
+    if (retry) {
+      m_io->wake();
+    }
+  }
+
+  return pos_type(pos);
+}
+
+ReadAheadStreambuf::pos_type
+ReadAheadStreambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+bool
+ReadAheadStreambuf::load_next_chunk()
+{
+  off_type const chunk_size = static_cast<off_type>(m_chunk_size);
+  off_type const num_chunks = (m_size + chunk_size - 1) / chunk_size;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  // drop what the reader left behind, keep the previous chunk
+  // around for short backward seeks
+  off_type const read_chunk = m_read_chunk;
+  std::erase_if(m_chunks, [this, read_chunk](auto const& it) {
+    return it.first < read_chunk - 1 || it.first >= read_chunk + m_chunks_ahead;
+  });
+
+  off_type next = -1;
+  if (!m_error) {
+    for(off_type chunk = read_chunk; chunk < std::min(read_chunk + m_chunks_ahead, num_chunks); ++chunk) {
+      if (!m_chunks.contains(chunk)) {
+        next = chunk;
+        break;
+      }
+    }
+  }
+
+  if (next < 0) {
+    return false;
+  }
+
+  lock.unlock();
+
+#ifdef __linux__
+  if (m_fd >= 0) {
+    // have the kernel fetch the window behind ours
+    posix_fadvise(m_fd, (next + m_chunks_ahead) * chunk_size, m_chunks_ahead * chunk_size,
+                  POSIX_FADV_WILLNEED);
+  }
+#endif
+
+  std::vector<char> data(static_cast<size_t>(std::min(chunk_size, m_size - next * chunk_size)));
+  m_source->clear();
+  m_source->seekg(next * chunk_size, std::ios::beg);
+  m_source->read(data.data(), static_cast<std::streamsize>(data.size()));
+  size_t const bytesread = static_cast<size_t>(std::max<std::streamsize>(0, m_source->gcount()));
+
+  lock.lock();
+  if (bytesread < data.size()) {
+    // readers get EOF from here on
+    data.resize(bytesread);
+    m_error = true;
+  }
+  m_chunks.emplace(next, std::move(data));
+  m_cond.notify_all();
+  return true;
+}
+
+std::unique_ptr<ReadAheadStream>
+ReadAheadStream::from_file(std::filesystem::path const& filename, std::shared_ptr<ReadAheadIO> io)
+{
+  auto in = std::make_unique<std::ifstream>(filename, std::ios::binary);
+  if (!*in) {
+    std::ostringstream msg;
+    msg << "Couldn't open '" << filename << "'";
+    throw SoundError(msg.str());
+  }
+
+  int fd = -1;
+#ifdef __linux__
+  fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+
+  return std::make_unique<ReadAheadStream>(std::move(in), std::move(io),
+                                           ReadAheadStreambuf::DEFAULT_CHUNK_SIZE,
+                                           ReadAheadStreambuf::DEFAULT_CHUNKS_AHEAD, fd);
+}
+
+ReadAheadStream::ReadAheadStream(std::unique_ptr<std::istream> source,
+                                 std::shared_ptr<ReadAheadIO> io,
+                                 size_t chunk_size, int chunks_ahead, int fd) :
+  std::istream(nullptr),
+  m_streambuf(std::move(source), std::move(io), chunk_size, chunks_ahead, fd)
+{
+  rdbuf(&m_streambuf);
+}
+
+} // namespace wstsound
+
+/* EOF */
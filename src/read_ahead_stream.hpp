@@ -0,0 +1,163 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_READ_AHEAD_STREAM_HPP
+#define HEADER_WSTSOUND_READ_AHEAD_STREAM_HPP
+
+#include <condition_variable>
+#include <filesystem>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace wstsound {
+
+class ReadAheadStreambuf;
+
+/** The background thread doing the reads of all the streams that
+    share it, SoundManager keeps a single one for all of its streams.
+    The thread is started with the first stream. */
+class ReadAheadIO
+{
+public:
+  ReadAheadIO();
+  ~ReadAheadIO();
+
+private:
+  friend class ReadAheadStreambuf;
+
+  void add(ReadAheadStreambuf* stream);
+
+  /** Blocks while the thread is reading for 'stream' */
+  void remove(ReadAheadStreambuf* stream);
+
+  /** Called when a stream moved on and has chunks to load */
+  void wake();
+
+  void run();
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::vector<ReadAheadStreambuf*> m_streams;
+  /** Stream the thread is currently reading for */
+  ReadAheadStreambuf* m_busy;
+  bool m_pending;
+  bool m_quit;
+  std::thread m_thread;
+
+private:
+  ReadAheadIO(const ReadAheadIO&) = delete;
+  ReadAheadIO& operator=(const ReadAheadIO&) = delete;
+};
+
+/** Streambuf that reads the underlying stream in aligned chunks on
+    the ReadAheadIO thread, ahead of the current read position. Reads
+    only block when they hit a chunk that isn't loaded yet, e.g. right
+    after a seek. */
+class ReadAheadStreambuf : public std::streambuf
+{
+public:
+  static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+  static const int DEFAULT_CHUNKS_AHEAD = 8;
+
+public:
+  /** 'fd' is an optional descriptor of the same file, used to give
+      the kernel readahead hints, it gets closed by the streambuf */
+  ReadAheadStreambuf(std::unique_ptr<std::istream> source,
+                     std::shared_ptr<ReadAheadIO> io,
+                     size_t chunk_size = DEFAULT_CHUNK_SIZE,
+                     int chunks_ahead = DEFAULT_CHUNKS_AHEAD,
+                     int fd = -1);
+  ~ReadAheadStreambuf() override;
+
+protected:
+  int_type underflow() override;
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which = std::ios_base::in) override;
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+
+private:
+  friend class ReadAheadIO;
+
+  /** Loads the first missing chunk of the window, called on the
+      ReadAheadIO thread, returns false when there was nothing to do */
+  bool load_next_chunk();
+
+  /** Position of the next character returned by underflow() */
+  off_type get_pos() const;
+
+private:
+  std::unique_ptr<std::istream> m_source;
+  std::shared_ptr<ReadAheadIO> m_io;
+  size_t m_chunk_size;
+  int m_chunks_ahead;
+  int m_fd;
+  off_type m_size;
+
+  /** Consumer side, the chunk the get area points into or -1 when
+      there is no get area, in which case m_pos is the read position */
+  off_type m_chunk;
+  off_type m_pos;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::map<off_type, std::vector<char>> m_chunks;
+
+  /** Chunk the consumer reads from, the worker loads ahead of it */
+  off_type m_read_chunk;
+
+  /** A read came up short, nothing more is loaded till the next seek */
+  bool m_error;
+
+private:
+  ReadAheadStreambuf(const ReadAheadStreambuf&) = delete;
+  ReadAheadStreambuf& operator=(const ReadAheadStreambuf&) = delete;
+};
+
+class ReadAheadStream : public std::istream
+{
+public:
+  /** Open 'filename', throws SoundError on failure */
+  static std::unique_ptr<ReadAheadStream> from_file(std::filesystem::path const& filename,
+                                                    std::shared_ptr<ReadAheadIO> io);
+
+public:
+  ReadAheadStream(std::unique_ptr<std::istream> source,
+                  std::shared_ptr<ReadAheadIO> io,
+                  size_t chunk_size = ReadAheadStreambuf::DEFAULT_CHUNK_SIZE,
+                  int chunks_ahead = ReadAheadStreambuf::DEFAULT_CHUNKS_AHEAD,
+                  int fd = -1);
+
+private:
+  ReadAheadStreambuf m_streambuf;
+
+private:
+  ReadAheadStream(const ReadAheadStream&) = delete;
+  ReadAheadStream& operator=(const ReadAheadStream&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
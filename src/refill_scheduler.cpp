@@ -0,0 +1,73 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "refill_scheduler.hpp"
+
+#include <algorithm>
+
+namespace wstsound {
+
+RefillScheduler::RefillScheduler() :
+  m_budget(0),
+  m_requests()
+{
+}
+
+void
+RefillScheduler::request(Client& client)
+{
+  if (std::find(m_requests.begin(), m_requests.end(), &client) == m_requests.end()) {
+    m_requests.emplace_back(&client);
+  }
+}
+
+void
+RefillScheduler::cancel(Client& client)
+{
+  std::erase(m_requests, &client);
+}
+
+void
+RefillScheduler::run()
+{
+  // the first fragment is always queued, even when it's larger than
+  // the budget, so things keep moving
+  size_t spent = 0;
+  while (!m_requests.empty() && (m_budget == 0 || spent < m_budget))
+  {
+    // deadlines change with every fragment queued, so pick again
+    auto it = std::min_element(m_requests.begin(), m_requests.end(),
+                               [](Client const* lhs, Client const* rhs) {
+                                 return lhs->get_time_to_underrun() < rhs->get_time_to_underrun();
+                               });
+
+    size_t const bytes = (*it)->refill_fragment();
+    if (bytes == 0) {
+      m_requests.erase(it);
+    } else {
+      spent += bytes;
+    }
+  }
+
+  // the rest asks again on its next update
+  m_requests.clear();
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,83 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_REFILL_SCHEDULER_HPP
+#define HEADER_WSTSOUND_REFILL_SCHEDULER_HPP
+
+#include <memory>
+#include <stddef.h>
+#include <vector>
+
+namespace wstsound {
+
+/** Refills streaming sources in order of how soon they would run dry
+    and stops once the per-update budget is spent. Sources register
+    themselves in their update(), SoundManager::update() then calls
+    run(). */
+class RefillScheduler
+{
+public:
+  class Client
+  {
+  public:
+    virtual ~Client() {}
+
+    /** Seconds of audio left in the queue */
+    virtual float get_time_to_underrun() const = 0;
+
+    /** Queue one more fragment, returns the number of bytes queued or
+        0 when there is nothing to do */
+    virtual size_t refill_fragment() = 0;
+  };
+
+  /** Time to underrun given to streams that haven't started yet, so
+      a burst of new streams is handled after the playing streams that
+      are about to run out */
+  static constexpr float START_DEADLINE = 0.1f;
+
+public:
+  RefillScheduler();
+
+  /** Bytes to queue per run(), 0 disables the scheduling and sources
+      refill themselves in their update() */
+  void set_budget(size_t bytes) { m_budget = bytes; }
+  size_t get_budget() const { return m_budget; }
+  bool is_enabled() const { return m_budget > 0; }
+
+  void request(Client& client);
+  void cancel(Client& client);
+
+  /** Refill the requested clients, most urgent first */
+  void run();
+
+private:
+  size_t m_budget;
+  std::vector<Client*> m_requests;
+
+private:
+  RefillScheduler(const RefillScheduler&) = delete;
+  RefillScheduler& operator=(const RefillScheduler&) = delete;
+};
+
+using RefillSchedulerPtr = std::shared_ptr<RefillScheduler>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -0,0 +1,120 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_RING_BUFFER_HPP
+#define HEADER_WSTSOUND_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <span>
+#include <string.h>
+#include <vector>
+
+namespace wstsound {
+
+/** Lock-free single-producer/single-consumer byte queue. write() must
+    only be called from one thread and read() from one other thread,
+    clear() requires both sides to be idle. */
+class RingBuffer
+{
+public:
+  RingBuffer(size_t capacity) :
+    m_data(capacity),
+    m_read_pos(0),
+    m_write_pos(0)
+  {}
+
+  size_t capacity() const { return m_data.size(); }
+
+  /** Number of bytes that can be read, call from the consumer */
+  size_t read_available() const
+  {
+    return m_write_pos.load(std::memory_order_acquire) - m_read_pos.load(std::memory_order_relaxed);
+  }
+
+  /** Number of bytes that can be written, call from the producer */
+  size_t write_available() const
+  {
+    return m_data.size() - (m_write_pos.load(std::memory_order_relaxed) -
+                            m_read_pos.load(std::memory_order_acquire));
+  }
+
+  size_t write(void const* data, size_t len)
+  {
+    size_t const write_pos = m_write_pos.load(std::memory_order_relaxed);
+    len = std::min(len, write_available());
+
+    size_t const offset = write_pos % m_data.size();
+    size_t const first = std::min(len, m_data.size() - offset);
+    memcpy(m_data.data() + offset, data, first);
+    memcpy(m_data.data(), static_cast<char const*>(data) + first, len - first);
+
+    m_write_pos.store(write_pos + len, std::memory_order_release);
+    return len;
+  }
+
+  /** Contiguous free space at the write position, lets the producer
+      write in place and publish the bytes with commit() */
+  std::span<char> write_span()
+  {
+    size_t const write_pos = m_write_pos.load(std::memory_order_relaxed);
+    size_t const offset = write_pos % m_data.size();
+    return { m_data.data() + offset, std::min(write_available(), m_data.size() - offset) };
+  }
+
+  void commit(size_t len)
+  {
+    size_t const write_pos = m_write_pos.load(std::memory_order_relaxed);
+    m_write_pos.store(write_pos + std::min(len, write_available()), std::memory_order_release);
+  }
+
+  size_t read(void* data, size_t len)
+  {
+    size_t const read_pos = m_read_pos.load(std::memory_order_relaxed);
+    len = std::min(len, read_available());
+
+    size_t const offset = read_pos % m_data.size();
+    size_t const first = std::min(len, m_data.size() - offset);
+    memcpy(data, m_data.data() + offset, first);
+    memcpy(static_cast<char*>(data) + first, m_data.data(), len - first);
+
+    m_read_pos.store(read_pos + len, std::memory_order_release);
+    return len;
+  }
+
+  void clear()
+  {
+    m_read_pos.store(0, std::memory_order_relaxed);
+    m_write_pos.store(0, std::memory_order_release);
+  }
+
+private:
+  std::vector<char> m_data;
+  std::atomic<size_t> m_read_pos;
+  std::atomic<size_t> m_write_pos;
+
+private:
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
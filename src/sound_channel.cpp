@@ -70,6 +70,69 @@ SoundChannel::prepare(std::filesystem::path const& filename,
   }
 }
 
+SoundSourcePtr
+SoundChannel::play(SoundId id, SoundSourceType type)
+{
+  SoundSourcePtr source = prepare(id, type);
+  source->play();
+
+  return source;
+}
+
+SoundSourcePtr
+SoundChannel::prepare(SoundId id, SoundSourceType type)
+{
+  try
+  {
+    SoundSourcePtr source = m_sound_manager.create_sound_source(id, *this, type);
+    source->update_gain();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+  catch(std::exception const& err)
+  {
+    // get_filename() would throw again for an unknown id
+    std::cerr << "SourceChannel::prepare: Couldn't load SoundId " << static_cast<uint32_t>(id) << ": " << err.what() << std::endl;
+    auto source = std::make_shared<DummySoundSource>();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+}
+
+SoundSourcePtr
+SoundChannel::play_async(std::filesystem::path const& filename,
+                         SoundSourceType type)
+{
+  SoundSourcePtr source = prepare_async(filename, type);
+  source->play();
+
+  return source;
+}
+
+SoundSourcePtr
+SoundChannel::prepare_async(std::filesystem::path const& filename,
+                            SoundSourceType type)
+{
+  try
+  {
+    SoundSourcePtr source = m_sound_manager.create_sound_source_async(filename, *this, type);
+    source->update_gain();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+  catch(std::exception const& err)
+  {
+    std::cerr << "SourceChannel::prepare_async: Couldn't load " << filename << ": " << err.what() << std::endl;
+    auto source = std::make_shared<DummySoundSource>();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+}
+
 SoundSourcePtr
 SoundChannel::play(std::unique_ptr<SoundFile> sound_file,
                    SoundSourceType type)
@@ -91,6 +154,108 @@ SoundChannel::prepare(std::unique_ptr<SoundFile> sound_file,
   return source;
 }
 
+std::shared_ptr<PushSoundSource>
+SoundChannel::prepare_push(SoundFormat const& format, JitterBufferConfig const& config)
+{
+  std::shared_ptr<PushSoundSource> source = m_sound_manager.create_push_sound_source(format, *this, config);
+  if (source) {
+    source->update_gain();
+    m_sound_sources.emplace_back(source);
+  }
+  return source;
+}
+
+SoundSourcePtr
+SoundChannel::play_stems(std::vector<std::filesystem::path> const& filenames)
+{
+  SoundSourcePtr source = prepare_stems(filenames);
+  source->play();
+
+  return source;
+}
+
+SoundSourcePtr
+SoundChannel::prepare_stems(std::vector<std::filesystem::path> const& filenames)
+{
+  try
+  {
+    SoundSourcePtr source = m_sound_manager.create_stem_sound_source(filenames, *this);
+    source->update_gain();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+  catch(std::exception const& err)
+  {
+    std::cerr << "SourceChannel::prepare_stems: Couldn't load stems: " << err.what() << std::endl;
+    auto source = std::make_shared<DummySoundSource>();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+}
+
+SoundSourcePtr
+SoundChannel::crossfade_to(std::filesystem::path const& filename, float duration,
+                           SoundSourceType type)
+{
+  std::unique_ptr<SoundFile> sound_file;
+  try
+  {
+    sound_file = m_sound_manager.open_stream_file(filename);
+  }
+  catch(std::exception const& err)
+  {
+    std::cerr << "SourceChannel::crossfade_to: Couldn't load " << filename << ": " << err.what() << std::endl;
+    auto source = std::make_shared<DummySoundSource>();
+
+    m_sound_sources.emplace_back(source);
+    return source;
+  }
+
+  SoundSourcePtr current;
+  for(auto it = m_sound_sources.rbegin(); it != m_sound_sources.rend(); ++it) {
+    if (auto source = it->lock()) {
+      if (source->get_state() == SourceState::Playing) {
+        current = source;
+        break;
+      }
+    }
+  }
+
+  auto stream = std::dynamic_pointer_cast<StreamSoundSource>(current);
+  if (stream && stream->can_crossfade_to(sound_file->get_format()))
+  {
+    stream->crossfade_to(std::move(sound_file), duration);
+
+    for(auto& source_wptr : m_sound_sources) {
+      if (auto source = source_wptr.lock()) {
+        if (source != stream && source->get_state() == SourceState::Playing) {
+          source->set_fading(FadeDirection::Out, duration, FadeCurve::EqualPower);
+        }
+      }
+    }
+
+    return stream;
+  }
+  else
+  {
+    for(auto& source_wptr : m_sound_sources) {
+      if (auto source = source_wptr.lock()) {
+        if (source->get_state() == SourceState::Playing) {
+          source->set_fading(FadeDirection::Out, duration, FadeCurve::EqualPower);
+        }
+      }
+    }
+
+    SoundSourcePtr source = prepare(std::move(sound_file), type);
+    source->set_fading(FadeDirection::In, duration, FadeCurve::EqualPower);
+    source->play();
+
+    return source;
+  }
+}
+
 void
 SoundChannel::set_gain(float gain)
 {
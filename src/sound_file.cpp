@@ -84,16 +84,16 @@ SoundFile::from_file(std::filesystem::path const& filename)
   }
 }
 
-float
+double
 SoundFile::get_duration() const
 {
-  return static_cast<float>(get_sample_duration()) / static_cast<float>(get_format().get_rate());
+  return static_cast<double>(get_sample_duration()) / static_cast<double>(get_format().get_rate());
 }
 
-int
+int64_t
 SoundFile::get_sample_duration() const
 {
-  return 8 * static_cast<int>(get_size()) / get_format().get_channels() / get_format().get_bits_per_sample();
+  return static_cast<int64_t>(get_size()) / static_cast<int64_t>(get_format().sample2bytes(1));
 }
 
 } // namespace wstsound
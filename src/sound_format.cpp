@@ -37,9 +37,9 @@ SoundFormat::SoundFormat(int rate, int channels, int bits_per_sample) :
 }
 
 size_t
-SoundFormat::sample2bytes(int sample) const
+SoundFormat::sample2bytes(int64_t sample) const
 {
-  return sample * get_channels() * get_bits_per_sample() / 8;
+  return static_cast<size_t>(sample * get_channels() * get_bits_per_sample() / 8);
 }
 
 ALenum
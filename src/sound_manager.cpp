@@ -16,34 +16,149 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <assert.h>
 #include <filesystem>
 #include <iostream>
+#include <limits>
+#include <future>
 #include <sstream>
+#include <thread>
 
 #include "openal_buffer.hpp"
+#include "buffer_cache.hpp"
+#include "callback_sound_source.hpp"
+#include "decode_worker.hpp"
 #include "dummy_sound_source.hpp"
 #include "effect.hpp"
 #include "effect_slot.hpp"
 #include "filter.hpp"
+#include "hybrid_sound_source.hpp"
+#include "loading_sound_source.hpp"
 #include "openal_system.hpp"
+#include "pcm_disk_cache.hpp"
+#include "read_ahead_stream.hpp"
+#include "refill_scheduler.hpp"
 #include "sound_error.hpp"
 #include "sound_file.hpp"
 #include "sound_manager.hpp"
 #include "sound_source_type.hpp"
+#include "source_events.hpp"
 #include "static_sound_source.hpp"
+#include "stem_sound_source.hpp"
+#include "stream_buffer_pool.hpp"
+#include "stream_hibernation.hpp"
 #include "stream_sound_source.hpp"
+#include "task_pool.hpp"
 
 namespace wstsound {
 
+namespace {
+
+// m_buffer_cache keys, loop variants always have sample_beg < sample_end
+std::tuple<std::filesystem::path, int64_t, int64_t>
+file_key(std::filesystem::path const& filename)
+{
+  return {filename, 0, 0};
+}
+
+std::tuple<std::filesystem::path, int64_t, int64_t>
+loop_key(std::filesystem::path const& filename, int64_t sample_beg, int64_t sample_end)
+{
+  return {filename, sample_beg, sample_end};
+}
+
+std::tuple<std::filesystem::path, int64_t, int64_t>
+hybrid_head_key(std::filesystem::path const& filename)
+{
+  return {filename, -1, -1};
+}
+
+/** Scratch memory above this is released after a load */
+size_t const MAX_SCRATCH_BYTES = 16 * 1024 * 1024;
+
+/** Decode up to 'size' bytes of 'file' into 'data', returns the bytes
+    read */
+size_t
+read_into(SoundFile& file, char* data, size_t size)
+{
+  size_t total_bytesread = 0;
+  while (total_bytesread < size) {
+    size_t const bytesread = file.read(data + total_bytesread,
+                                       std::min<size_t>(1024 * 64, size - total_bytesread));
+    if (bytesread == 0) {
+      break;
+    }
+    total_bytesread += bytesread;
+  }
+  return total_bytesread;
+}
+
+/** Decode all of 'file' into 'samples', which is resized to fit and
+    can be reused to keep its memory */
+void
+read_all(SoundFile& file, std::vector<char>& samples)
+{
+  size_t const chunk_size = 1024 * 64;
+
+  samples.resize(file.get_size());
+  size_t total_bytesread = 0;
+  while (true) {
+    // some formats only know their size approximately
+    if (samples.size() - total_bytesread < chunk_size) {
+      samples.resize(total_bytesread + chunk_size);
+    }
+
+    size_t const bytesread = file.read(samples.data() + total_bytesread, chunk_size);
+    if (bytesread == 0) {
+      break;
+    }
+    total_bytesread += bytesread;
+  }
+  samples.resize(total_bytesread);
+}
+
+} // namespace
+
+/** A file registered with register_sound() */
+struct SoundManager::RegisteredSound
+{
+  std::filesystem::path filename;
+
+  /** The cached STATIC buffer of the file, refreshed on a miss */
+  BufferCache<std::tuple<std::filesystem::path, int64_t, int64_t>, OpenALBufferPtr>::Ref buffer;
+};
+
 SoundManager::SoundManager(std::unique_ptr<OpenALSystem> openal,
                            OpenFunc open_func) :
   m_openal(std::move(openal)),
   m_open_func(std::move(open_func)),
   m_listener(*this),
   m_channels(),
-  m_buffer_cache(),
-  m_managed_sources()
+  m_buffer_cache(std::make_unique<BufferCache<std::tuple<std::filesystem::path, int64_t, int64_t>, OpenALBufferPtr>>()),
+  m_hybrid_head_cache(),
+  m_pinned(),
+  m_preload_executor(),
+  m_task_pool(),
+  m_preload_jobs(),
+  m_deferred_static_loading(false),
+  m_deferred_static_max_latency(0.1f),
+  m_static_loads(),
+  m_scratch(),
+  m_disk_cache(),
+  m_sounds(),
+  m_sound_ids(),
+  m_managed_sources(),
+  m_decode_worker(),
+  m_refill_scheduler(std::make_shared<RefillScheduler>()),
+  m_stream_buffer_pool(std::make_shared<StreamBufferPool>()),
+  m_source_events(),
+  m_stream_hibernation(std::make_shared<StreamHibernation>()),
+  m_event_driven_updates(false),
+  m_stream_buffer_policy(),
+  m_stream_read_ahead(true),
+  m_read_ahead_io(std::make_shared<ReadAheadIO>()),
+  m_self(this, [](SoundManager*) {})
 {
   m_channels.emplace_back(std::make_unique<SoundChannel>(*this));
   m_channels.emplace_back(std::make_unique<SoundChannel>(*this));
@@ -55,8 +170,30 @@ SoundManager::SoundManager(OpenFunc open_func) :
   m_open_func(std::move(open_func)),
   m_listener(*this),
   m_channels(),
-  m_buffer_cache(),
-  m_managed_sources()
+  m_buffer_cache(std::make_unique<BufferCache<std::tuple<std::filesystem::path, int64_t, int64_t>, OpenALBufferPtr>>()),
+  m_hybrid_head_cache(),
+  m_pinned(),
+  m_preload_executor(),
+  m_task_pool(),
+  m_preload_jobs(),
+  m_deferred_static_loading(false),
+  m_deferred_static_max_latency(0.1f),
+  m_static_loads(),
+  m_scratch(),
+  m_disk_cache(),
+  m_sounds(),
+  m_sound_ids(),
+  m_managed_sources(),
+  m_decode_worker(),
+  m_refill_scheduler(std::make_shared<RefillScheduler>()),
+  m_stream_buffer_pool(std::make_shared<StreamBufferPool>()),
+  m_source_events(),
+  m_stream_hibernation(std::make_shared<StreamHibernation>()),
+  m_event_driven_updates(false),
+  m_stream_buffer_policy(),
+  m_stream_read_ahead(true),
+  m_read_ahead_io(std::make_shared<ReadAheadIO>()),
+  m_self(this, [](SoundManager*) {})
 {
   m_channels.emplace_back(std::make_unique<SoundChannel>(*this));
   m_channels.emplace_back(std::make_unique<SoundChannel>(*this));
@@ -74,50 +211,555 @@ SoundManager::SoundManager(OpenFunc open_func) :
 
 SoundManager::~SoundManager()
 {
+  // callbacks held by sources that are still around become no-ops
+  m_self.reset();
 }
 
 OpenALBufferPtr
 SoundManager::load_file_into_buffer(std::unique_ptr<SoundFile> file)
 {
-  std::vector<char> samples(file->get_size());
-  size_t total_bytesread = 0;
-  while (true) {
-    size_t bytesread = file->read(samples.data() + total_bytesread, 1024 * 64);
-    if (bytesread == 0) {
-      break;
+  SoundFormat const format = file->get_format();
+  size_t const size = file->get_size();
+
+  // decode straight into the AL buffer, saving the copy; only works
+  // when the size is exact, which it isn't for every format
+  if (size > 0 && size <= static_cast<size_t>(std::numeric_limits<ALsizei>::max()) &&
+      OpenALBuffer::is_map_supported())
+  {
+    auto buffer = OpenALBuffer::create();
+    buffer->set_storage(format.get_openal_format(), static_cast<ALsizei>(size), format.get_rate());
+
+    size_t bytesread = 0;
+    try {
+      bytesread = read_into(*file, static_cast<char*>(buffer->map(static_cast<ALsizei>(size))), size);
+    } catch(...) {
+      buffer->unmap();
+      throw;
     }
-    total_bytesread += bytesread;
+    buffer->unmap();
+
+    // decoders can't return less than a frame, so probe with a whole
+    // one; anything left means the size was short
+    std::vector<char> probe(format.sample2bytes(1));
+    if (bytesread == size && file->read(probe.data(), probe.size()) == 0) {
+      return buffer;
+    }
+
+    file->seek_to_sample(0);
+  }
+
+  read_all(*file, m_scratch);
+  OpenALBufferPtr buffer = m_openal->create_buffer(format.get_openal_format(),
+                                                   m_scratch.data(),
+                                                   static_cast<ALsizei>(m_scratch.size()),
+                                                   format.get_rate());
+
+  if (m_scratch.capacity() > MAX_SCRATCH_BYTES) {
+    std::vector<char>().swap(m_scratch);
+  }
+
+  return buffer;
+}
+
+OpenALBufferPtr
+SoundManager::load_static_buffer(std::filesystem::path const& filename)
+{
+  if (!m_disk_cache) {
+    return load_file_into_buffer(load_sound_file(filename));
+  }
+
+  if (OpenALBuffer::is_map_supported())
+  {
+    // read hits straight into the AL buffer
+    OpenALBufferPtr buffer;
+    void* mapped = nullptr;
+    bool const hit = m_disk_cache->load(filename, [&buffer, &mapped](SoundFormat const& format, size_t size) -> char* {
+      if (size == 0 || size > static_cast<size_t>(std::numeric_limits<ALsizei>::max())) {
+        return nullptr;
+      }
+
+      buffer = OpenALBuffer::create();
+      buffer->set_storage(format.get_openal_format(), static_cast<ALsizei>(size), format.get_rate());
+      mapped = buffer->map(static_cast<ALsizei>(size));
+      return static_cast<char*>(mapped);
+    });
+
+    if (mapped) {
+      buffer->unmap();
+    }
+
+    if (hit) {
+      return buffer;
+    }
+  }
+  else
+  {
+    SoundFormat format;
+    if (m_disk_cache->load(filename, format, m_scratch)) {
+      OpenALBufferPtr buffer = m_openal->create_buffer(format.get_openal_format(),
+                                                       m_scratch.data(),
+                                                       static_cast<ALsizei>(m_scratch.size()),
+                                                       format.get_rate());
+
+      if (m_scratch.capacity() > MAX_SCRATCH_BYTES) {
+        std::vector<char>().swap(m_scratch);
+      }
+
+      return buffer;
+    }
+  }
+
+  // a miss, the PCM is handed over to the task writing the entry, so
+  // it doesn't go through m_scratch
+  std::unique_ptr<SoundFile> file = load_sound_file(filename);
+  SoundFormat const format = file->get_format();
+  auto data = std::make_shared<std::vector<char>>();
+  read_all(*file, *data);
+
+  OpenALBufferPtr buffer = m_openal->create_buffer(format.get_openal_format(),
+                                                   data->data(),
+                                                   static_cast<ALsizei>(data->size()),
+                                                   format.get_rate());
+
+  post_task([disk_cache = m_disk_cache, filename, format, data]{
+    disk_cache->store(filename, format, data->data(), data->size());
+  });
+
+  return buffer;
+}
 
-    assert(total_bytesread <= file->get_size());
+SoundSourcePtr
+SoundManager::create_stem_sound_source(std::vector<std::filesystem::path> const& filenames,
+                                       SoundChannel& channel)
+{
+  if (!m_openal) {
+    return SoundSourcePtr(new DummySoundSource);
   }
 
-  return m_openal->create_buffer(file->get_format().get_openal_format(),
-                                 samples.data(),
-                                 static_cast<ALsizei>(total_bytesread),
-                                 file->get_format().get_rate());
+  std::vector<std::unique_ptr<SoundFile>> sound_files;
+  for(auto const& filename : filenames) {
+    sound_files.emplace_back(open_stream_file(filename));
+  }
+
+  return SoundSourcePtr(new StemSoundSource(channel, std::move(sound_files), m_decode_worker,
+                                            m_stream_buffer_policy, m_stream_buffer_pool));
 }
 
+OpenALBufferPtr
+SoundManager::get_loop_buffer(std::filesystem::path const& filename, int64_t sample_beg, int64_t sample_end)
+{
+  auto const key = loop_key(filename, sample_beg, sample_end);
+
+  if (OpenALBufferPtr buffer = m_buffer_cache->get(key)) {
+    return buffer;
+  }
+
+  // OpenAL can't copy buffers, so load the file again
+  OpenALBufferPtr buffer = load_static_buffer(filename);
+  buffer->set_loop_points(sample_beg, sample_end);
+  m_buffer_cache->insert(key, buffer, buffer->get_size());
+  return buffer;
+}
+
+OpenALBufferPtr
+SoundManager::get_static_buffer(std::filesystem::path const& filename)
+{
+  auto const key = file_key(filename);
+
+  if (OpenALBufferPtr buffer = m_buffer_cache->get(key)) {
+    return buffer;
+  }
+
+  OpenALBufferPtr buffer = load_static_buffer(filename);
+  m_buffer_cache->insert(key, buffer, buffer->get_size(), m_pinned.contains(filename));
+  return buffer;
+}
+
+std::shared_ptr<HybridHead>
+SoundManager::get_hybrid_head(std::filesystem::path const& filename)
+{
+  auto it = m_hybrid_head_cache.find(filename);
+  if (it == m_hybrid_head_cache.end()) {
+    return {};
+  }
+
+  OpenALBufferPtr buffer = m_buffer_cache->get(hybrid_head_key(filename));
+  if (!buffer) {
+    // evicted, the head has to be decoded again
+    m_hybrid_head_cache.erase(it);
+    return {};
+  }
+
+  auto head = std::make_shared<HybridHead>(*it->second);
+  head->buffer = std::move(buffer);
+  return head;
+}
+
+void
+SoundManager::cache_hybrid_head(std::filesystem::path const& filename, HybridHead const& head)
+{
+  auto info = std::make_shared<HybridHead>(head);
+  info->buffer.reset();
+  m_hybrid_head_cache[filename] = std::move(info);
+
+  m_buffer_cache->insert(hybrid_head_key(filename), head.buffer, head.buffer->get_size(),
+                         m_pinned.contains(filename));
+}
+
+void
+SoundManager::set_buffer_cache_budget(size_t bytes)
+{
+  m_buffer_cache->set_budget(bytes);
+}
+
+size_t
+SoundManager::get_buffer_cache_size() const
+{
+  return m_buffer_cache->get_size();
+}
+
+void
+SoundManager::pin(std::filesystem::path const& filename)
+{
+  m_pinned.insert(filename);
+  m_buffer_cache->set_pinned(file_key(filename), true);
+  m_buffer_cache->set_pinned(hybrid_head_key(filename), true);
+}
+
+void
+SoundManager::unpin(std::filesystem::path const& filename)
+{
+  m_pinned.erase(filename);
+  m_buffer_cache->set_pinned(file_key(filename), false);
+  m_buffer_cache->set_pinned(hybrid_head_key(filename), false);
+  m_buffer_cache->trim();
+}
+
+void
+SoundManager::unload(std::filesystem::path const& filename)
+{
+  m_pinned.erase(filename);
+  m_hybrid_head_cache.erase(filename);
+  m_buffer_cache->erase_if([&filename](auto const& key) {
+    return std::get<0>(key) == filename;
+  });
+}
+
+void
+SoundManager::clear_buffer_cache()
+{
+  m_buffer_cache->clear();
+
+  std::erase_if(m_hybrid_head_cache, [this](auto const& it) {
+    return !m_buffer_cache->contains(hybrid_head_key(it.first));
+  });
+}
+
+namespace {
+
 std::unique_ptr<SoundFile>
-SoundManager::load_sound_file(std::filesystem::path const& filename)
+open_sound_file(OpenFunc const& open_func, std::filesystem::path const& filename)
 {
-  if (m_open_func) {
-    auto is = m_open_func(filename);
+  if (open_func) {
+    auto is = open_func(filename);
     return SoundFile::from_stream(std::move(is));
   } else {
     return SoundFile::from_file(filename);
   }
 }
 
+std::unique_ptr<SoundFile>
+open_stream_sound_file(OpenFunc const& open_func, std::shared_ptr<ReadAheadIO> const& read_ahead_io,
+                       std::filesystem::path const& filename)
+{
+  if (!read_ahead_io) {
+    return open_sound_file(open_func, filename);
+  }
+
+  std::unique_ptr<std::istream> is;
+  if (open_func) {
+    is = std::make_unique<ReadAheadStream>(open_func(filename), read_ahead_io);
+  } else {
+    is = ReadAheadStream::from_file(filename, read_ahead_io);
+  }
+
+  try {
+    return SoundFile::from_stream(std::move(is));
+  } catch(std::exception& e) {
+    std::ostringstream msg;
+    msg << "Couldn't read '" << filename << "': " << e.what();
+    throw SoundError(msg.str());
+  }
+}
+
+} // namespace
+
+std::unique_ptr<SoundFile>
+SoundManager::load_sound_file(std::filesystem::path const& filename)
+{
+  return open_sound_file(m_open_func, filename);
+}
+
+std::unique_ptr<SoundFile>
+SoundManager::open_stream_file(std::filesystem::path const& filename)
+{
+  return open_stream_sound_file(m_open_func, get_stream_read_ahead_io(), filename);
+}
+
 void
-SoundManager::preload(std::filesystem::path const& filename)
+SoundManager::preload(std::filesystem::path const& filename, SoundSourceType type)
 {
   if (!m_openal) { return; }
 
-  auto it = m_buffer_cache.find(filename);
-  if (it == m_buffer_cache.end())
+  if (type == SoundSourceType::HYBRID)
+  {
+    if (!get_hybrid_head(filename)) {
+      cache_hybrid_head(filename, *load_hybrid_head(*load_sound_file(filename)));
+    }
+    return;
+  }
+
+  get_static_buffer(filename);
+}
+
+void
+SoundManager::set_disk_cache(std::filesystem::path const& directory, uint64_t max_bytes)
+{
+  if (directory.empty()) {
+    m_disk_cache.reset();
+  } else {
+    // running preload tasks keep using the old one
+    m_disk_cache = std::make_shared<PCMDiskCache>(directory, max_bytes, m_open_func);
+    m_disk_cache->trim();
+  }
+}
+
+SoundId
+SoundManager::register_sound(std::filesystem::path const& filename)
+{
+  auto it = m_sound_ids.find(filename);
+  if (it != m_sound_ids.end()) {
+    return it->second;
+  }
+
+  SoundId const id = static_cast<SoundId>(m_sounds.size());
+  m_sounds.emplace_back(RegisteredSound{filename, {}});
+  m_sound_ids.emplace(filename, id);
+  return id;
+}
+
+std::filesystem::path const&
+SoundManager::get_filename(SoundId id) const
+{
+  if (static_cast<size_t>(id) >= m_sounds.size()) {
+    throw std::invalid_argument("unknown SoundId");
+  }
+
+  return m_sounds[static_cast<size_t>(id)].filename;
+}
+
+PreloadJobPtr
+SoundManager::preload_async(std::span<std::filesystem::path const> filenames)
+{
+  auto job = std::make_shared<PreloadJob>(filenames.size());
+
+  std::vector<std::filesystem::path> pending;
+  for(auto const& filename : filenames) {
+    if (!m_openal || m_buffer_cache->contains(file_key(filename))) {
+      job->m_done += 1;
+    } else {
+      pending.emplace_back(filename);
+    }
+  }
+
+  if (pending.empty()) {
+    job->m_finished = true;
+    job->m_promise.set_value();
+    return job;
+  }
+
+  job->m_outstanding = pending.size();
+  m_preload_jobs.emplace_back(job);
+
+  for(auto& filename : pending)
   {
-    OpenALBufferPtr buffer = load_file_into_buffer(load_sound_file(filename));
-    m_buffer_cache.insert(std::make_pair(filename, std::move(buffer)));
+    post_task(
+      [job, open_func = m_open_func, disk_cache = m_disk_cache, filename = std::move(filename)]{
+        PreloadJob::Decoded decoded{filename, {}, {}, {}};
+
+        if (job->m_cancelled) {
+          decoded.error = "cancelled";
+        } else {
+          try {
+            if (!disk_cache || !disk_cache->load(filename, decoded.format, decoded.data)) {
+              std::unique_ptr<SoundFile> sound_file = open_sound_file(open_func, filename);
+              decoded.format = sound_file->get_format();
+              read_all(*sound_file, decoded.data);
+              if (disk_cache) {
+                disk_cache->store(filename, decoded.format, decoded.data.data(), decoded.data.size());
+              }
+            }
+          } catch(std::exception const& err) {
+            decoded.error = err.what();
+          }
+        }
+
+        std::lock_guard<std::mutex> lock(job->m_mutex);
+        job->m_decoded.emplace_back(std::move(decoded));
+        job->m_outstanding -= 1;
+      });
+  }
+
+  return job;
+}
+
+void
+SoundManager::post_task(std::function<void ()> task)
+{
+  if (m_preload_executor) {
+    m_preload_executor(std::move(task));
+    return;
+  }
+
+  if (!m_task_pool) {
+    m_task_pool = std::make_shared<TaskPool>(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+  }
+  m_task_pool->post(std::move(task));
+}
+
+void
+SoundManager::set_preload_executor(PreloadExecutor executor)
+{
+  m_preload_executor = std::move(executor);
+}
+
+void
+SoundManager::set_deferred_static_loading(bool enable, float max_latency)
+{
+  m_deferred_static_loading = enable;
+  m_deferred_static_max_latency = max_latency;
+}
+
+void
+SoundManager::update_preload_jobs()
+{
+  std::erase_if(m_preload_jobs, [this](PreloadJobPtr const& job) {
+    std::vector<PreloadJob::Decoded> decoded;
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(job->m_mutex);
+      decoded.swap(job->m_decoded);
+      done = (job->m_outstanding == 0);
+    }
+
+    for(auto& file : decoded)
+    {
+      if (job->m_cancelled) {
+        // dropped, not uploaded
+      } else if (!file.error.empty()) {
+        std::lock_guard<std::mutex> lock(job->m_mutex);
+        job->m_errors.emplace_back(file.filename, file.error);
+      } else if (!m_buffer_cache->contains(file_key(file.filename))) {
+        // alBufferData() has to happen on the thread owning the context
+        try {
+          OpenALBufferPtr buffer = m_openal->create_buffer(file.format.get_openal_format(),
+                                                           file.data.data(),
+                                                           static_cast<ALsizei>(file.data.size()),
+                                                           file.format.get_rate());
+          m_buffer_cache->insert(file_key(file.filename), buffer, buffer->get_size(),
+                                 m_pinned.contains(file.filename));
+        } catch(std::exception const& err) {
+          std::lock_guard<std::mutex> lock(job->m_mutex);
+          job->m_errors.emplace_back(file.filename, err.what());
+        }
+      }
+      job->m_done += 1;
+    }
+
+    // a cancelled job doesn't wait for tasks that are still running
+    if (done || job->m_cancelled) {
+      job->m_finished = true;
+      job->m_promise.set_value();
+      return true;
+    }
+
+    return false;
+  });
+
+  std::erase_if(m_static_loads, [](auto const& it) {
+    return it.second->is_finished();
+  });
+}
+
+void
+SoundManager::set_refill_budget(size_t bytes)
+{
+  m_refill_scheduler->set_budget(bytes);
+}
+
+void
+SoundManager::set_event_driven_updates(bool enable)
+{
+  // the SourceEvents stay around once created, as there can only be
+  // one event callback per context and older sources still use it
+  if (enable && !m_source_events && m_openal && SourceEvents::is_supported()) {
+    m_source_events = std::make_shared<SourceEvents>();
+  }
+
+  m_event_driven_updates = enable;
+}
+
+void
+SoundManager::set_stream_hibernation(float idle_timeout, size_t max_open_decoders)
+{
+  m_stream_hibernation->set_idle_timeout(idle_timeout);
+  m_stream_hibernation->set_max_open(max_open_decoders);
+}
+
+void
+SoundManager::enable_hibernation(StreamSoundSource& source, std::filesystem::path const& filename)
+{
+  source.enable_hibernation(m_stream_hibernation,
+                            [open_func = m_open_func, read_ahead_io = get_stream_read_ahead_io(), filename]{
+                              return open_stream_sound_file(open_func, read_ahead_io, filename);
+                            });
+}
+
+std::shared_ptr<ReadAheadIO>
+SoundManager::get_stream_read_ahead_io() const
+{
+  return m_stream_read_ahead ? m_read_ahead_io : nullptr;
+}
+
+std::shared_ptr<SourceEvents>
+SoundManager::get_stream_source_events() const
+{
+  return m_event_driven_updates ? m_source_events : nullptr;
+}
+
+void
+SoundManager::reserve_stream_buffers(size_t count)
+{
+  if (!m_openal) { return; }
+
+  m_stream_buffer_pool->reserve(count);
+}
+
+size_t
+SoundManager::get_stream_buffer_high_water_mark() const
+{
+  return m_stream_buffer_pool->get_high_water_mark();
+}
+
+void
+SoundManager::set_decode_threads(int num_threads)
+{
+  // sources keep their own reference, so the old worker stays alive
+  // until the last stream using it is gone
+  if (num_threads <= 0) {
+    m_decode_worker.reset();
+  } else {
+    m_decode_worker = std::make_shared<DecodeWorker>(num_threads);
   }
 }
 
@@ -137,7 +779,16 @@ SoundManager::create_sound_source(std::unique_ptr<SoundFile> sound_file,
                                                   load_file_into_buffer(std::move(sound_file))));
 
     case SoundSourceType::STREAM:
-      return SoundSourcePtr(new StreamSoundSource(channel, std::move(sound_file)));
+      return SoundSourcePtr(new StreamSoundSource(channel, std::move(sound_file), m_decode_worker,
+                                                  m_stream_buffer_policy, m_refill_scheduler,
+                                                  m_stream_buffer_pool, get_stream_source_events()));
+
+    case SoundSourceType::MIXER_CALLBACK:
+      return create_callback_sound_source(std::move(sound_file), channel);
+
+    case SoundSourceType::HYBRID:
+      // without a filename there is nothing to cache the head for
+      return create_sound_source(std::move(sound_file), channel, SoundSourceType::STREAM);
   }
 
   throw std::invalid_argument("invalid SoundSourceType");
@@ -154,33 +805,244 @@ SoundManager::create_sound_source(std::filesystem::path const& filename, SoundCh
   switch(type)
   {
     case SoundSourceType::STATIC:
-      {
-        OpenALBufferPtr buffer;
-
-        // reuse an existing static sound buffer
-        auto it = m_buffer_cache.find(filename);
-        if (it != m_buffer_cache.end()) {
-          buffer = it->second;
-        } else {
-          buffer = load_file_into_buffer(load_sound_file(filename));
-          m_buffer_cache.insert(std::make_pair(filename, buffer));
-        }
-
-        return SoundSourcePtr(new StaticSoundSource(channel, buffer));
+      if (m_deferred_static_loading && !m_buffer_cache->contains(file_key(filename))) {
+        return create_deferred_static_sound_source(filename, channel);
       }
-      break;
+      return create_static_sound_source(filename, channel);
 
     case SoundSourceType::STREAM:
       {
-        std::unique_ptr<SoundFile> sound_file = load_sound_file(filename);
-        return SoundSourcePtr(new StreamSoundSource(channel, std::move(sound_file)));
+        std::unique_ptr<SoundFile> sound_file = open_stream_file(filename);
+        auto source = std::make_shared<StreamSoundSource>(channel, std::move(sound_file), m_decode_worker,
+                                                          m_stream_buffer_policy, m_refill_scheduler,
+                                                          m_stream_buffer_pool, get_stream_source_events());
+        enable_hibernation(*source, filename);
+        return source;
       }
       break;
+
+    case SoundSourceType::MIXER_CALLBACK:
+      return create_callback_sound_source(open_stream_file(filename), channel);
+
+    case SoundSourceType::HYBRID:
+      return create_hybrid_sound_source(filename, channel);
   }
 
   throw std::invalid_argument("invalid SoundSourceType");
 }
 
+SoundSourcePtr
+SoundManager::create_sound_source(SoundId id, SoundChannel& channel, SoundSourceType type)
+{
+  if (!m_openal) {
+    return SoundSourcePtr(new DummySoundSource);
+  }
+
+  if (static_cast<size_t>(id) >= m_sounds.size()) {
+    throw std::invalid_argument("unknown SoundId");
+  }
+
+  RegisteredSound& sound = m_sounds[static_cast<size_t>(id)];
+
+  if (type != SoundSourceType::STATIC) {
+    return create_sound_source(sound.filename, channel, type);
+  }
+
+  OpenALBufferPtr buffer = m_buffer_cache->get(sound.buffer);
+  if (!buffer) {
+    if (m_deferred_static_loading && !m_buffer_cache->contains(file_key(sound.filename))) {
+      return create_deferred_static_sound_source(sound.filename, channel);
+    }
+
+    buffer = get_static_buffer(sound.filename);
+    sound.buffer = m_buffer_cache->get_ref(file_key(sound.filename));
+  }
+
+  // the id is cheaper to capture than a copy of the path
+  return SoundSourcePtr(new StaticSoundSource(channel, buffer,
+                                              [self = std::weak_ptr(m_self), id](int64_t sample_beg, int64_t sample_end) {
+                                                auto manager = self.lock();
+                                                if (!manager) {
+                                                  throw SoundError("SoundManager is gone, can't load loop buffer");
+                                                }
+                                                return manager->get_loop_buffer(manager->get_filename(id), sample_beg, sample_end);
+                                              }));
+}
+
+SoundSourcePtr
+SoundManager::create_static_sound_source(std::filesystem::path const& filename, SoundChannel& channel)
+{
+  // reuse an existing static sound buffer
+  OpenALBufferPtr buffer = get_static_buffer(filename);
+
+  return SoundSourcePtr(new StaticSoundSource(channel, buffer,
+                                              [self = std::weak_ptr(m_self), filename](int64_t sample_beg, int64_t sample_end) {
+                                                auto manager = self.lock();
+                                                if (!manager) {
+                                                  throw SoundError("SoundManager is gone, can't load loop buffer");
+                                                }
+                                                return manager->get_loop_buffer(filename, sample_beg, sample_end);
+                                              }));
+}
+
+SoundSourcePtr
+SoundManager::create_deferred_static_sound_source(std::filesystem::path const& filename, SoundChannel& channel)
+{
+  PreloadJobPtr& job = m_static_loads[filename];
+  if (!job || job->is_finished()) {
+    job = preload_async(std::span(&filename, 1));
+  }
+
+  auto source = std::make_shared<LoadingSoundSource>(
+    job->get_future(),
+    [self = std::weak_ptr(m_self), &channel, filename, job]{
+      auto manager = self.lock();
+      if (!manager) {
+        throw SoundError("SoundManager is gone");
+      }
+
+      auto const errors = job->get_errors();
+      if (!errors.empty()) {
+        throw SoundError(errors.front().second);
+      }
+      // a cache miss here, e.g. after the buffer got evicted, decodes
+      // the file right away
+      return manager->create_static_sound_source(filename, channel);
+    });
+  source->set_max_latency(m_deferred_static_max_latency);
+  return source;
+}
+
+std::shared_ptr<PushSoundSource>
+SoundManager::create_push_sound_source(SoundFormat const& format, SoundChannel& channel,
+                                       JitterBufferConfig const& config)
+{
+  if (!m_openal) {
+    return {};
+  }
+
+  return std::make_shared<PushSoundSource>(channel, format, config);
+}
+
+std::shared_ptr<HybridHead>
+SoundManager::load_hybrid_head(SoundFile& sound_file)
+{
+  SoundFormat const format = sound_file.get_format();
+  int64_t const sample_duration = sound_file.get_sample_duration();
+  int64_t const head_samples = std::min<int64_t>(format.get_rate() * HybridSoundSource::HEAD_MSEC / 1000, sample_duration);
+
+  std::vector<char> samples(format.sample2bytes(head_samples));
+  size_t total_bytesread = 0;
+  while (total_bytesread < samples.size()) {
+    size_t const bytesread = sound_file.read(samples.data() + total_bytesread, samples.size() - total_bytesread);
+    if (bytesread == 0) {
+      break;
+    }
+    total_bytesread += bytesread;
+  }
+
+  OpenALBufferPtr buffer = m_openal->create_buffer(format.get_openal_format(),
+                                                   samples.data(),
+                                                   static_cast<ALsizei>(total_bytesread),
+                                                   format.get_rate());
+
+  return std::make_shared<HybridHead>(HybridHead{
+      buffer,
+      format,
+      static_cast<int64_t>(total_bytesread / format.sample2bytes(1)),
+      sample_duration
+    });
+}
+
+SoundSourcePtr
+SoundManager::create_hybrid_sound_source(std::filesystem::path const& filename, SoundChannel& channel)
+{
+  StreamBufferPolicy const policy = m_stream_buffer_policy.get_fixed();
+  bool const threaded = static_cast<bool>(m_decode_worker);
+
+  std::future<StreamReaderPtr> tail;
+  std::shared_ptr<HybridHead> head = get_hybrid_head(filename);
+
+  if (!head)
+  {
+    // first use, decode the head here and let the file continue as the tail
+    std::unique_ptr<SoundFile> sound_file = open_stream_file(filename);
+    head = load_hybrid_head(*sound_file);
+    cache_hybrid_head(filename, *head);
+
+    size_t const ring_buffer_size = threaded ? policy.get_max_bytes(head->format) : 0;
+    std::promise<StreamReaderPtr> promise;
+    promise.set_value(std::make_shared<StreamReader>(std::move(sound_file), ring_buffer_size));
+    tail = promise.get_future();
+  }
+  else
+  {
+    size_t const ring_buffer_size = threaded ? policy.get_max_bytes(head->format) : 0;
+    auto task = std::make_shared<std::packaged_task<StreamReaderPtr ()>>(
+      [open_func = m_open_func, read_ahead_io = get_stream_read_ahead_io(), filename,
+       head_samples = head->sample_count, ring_buffer_size]{
+        auto reader = std::make_shared<StreamReader>(open_stream_sound_file(open_func, read_ahead_io, filename),
+                                                     ring_buffer_size);
+        reader->seek_to_sample(head_samples);
+        return reader;
+      });
+    tail = task->get_future();
+    post_task([task]{ (*task)(); });
+  }
+
+  return SoundSourcePtr(new HybridSoundSource(channel, *head, std::move(tail), m_decode_worker,
+                                              policy, m_stream_buffer_pool));
+}
+
+SoundSourcePtr
+SoundManager::create_sound_source_async(std::filesystem::path const& filename, SoundChannel& channel,
+                                        SoundSourceType type)
+{
+  // HYBRID only opens the tail in the background anyway
+  if (!m_openal || type == SoundSourceType::STATIC || type == SoundSourceType::HYBRID) {
+    return create_sound_source(filename, channel, type);
+  }
+
+  // std::function needs something copyable
+  auto task = std::make_shared<std::packaged_task<std::unique_ptr<SoundFile> ()>>(
+    [open_func = m_open_func, read_ahead_io = get_stream_read_ahead_io(), filename]{
+      std::unique_ptr<SoundFile> sound_file = open_stream_sound_file(open_func, read_ahead_io, filename);
+      // some formats only figure out their length when asked
+      sound_file->get_size();
+      return sound_file;
+    });
+  std::future<std::unique_ptr<SoundFile>> sound_file = task->get_future();
+  post_task([task]{ (*task)(); });
+
+  return std::make_shared<LoadingSoundSource>(
+    std::move(sound_file),
+    [self = std::weak_ptr(m_self), &channel, type, filename](std::unique_ptr<SoundFile> file) {
+      auto manager = self.lock();
+      if (!manager) {
+        throw SoundError("SoundManager is gone");
+      }
+
+      SoundSourcePtr source = manager->create_sound_source(std::move(file), channel, type);
+      if (auto* stream = dynamic_cast<StreamSoundSource*>(source.get())) {
+        manager->enable_hibernation(*stream, filename);
+      }
+      return source;
+    });
+}
+
+SoundSourcePtr
+SoundManager::create_callback_sound_source(std::unique_ptr<SoundFile> sound_file, SoundChannel& channel)
+{
+  if (!CallbackSoundSource::is_supported()) {
+    return SoundSourcePtr(new StreamSoundSource(channel, std::move(sound_file), m_decode_worker,
+                                                m_stream_buffer_policy, m_refill_scheduler,
+                                                m_stream_buffer_pool, get_stream_source_events()));
+  }
+
+  return SoundSourcePtr(new CallbackSoundSource(channel, std::move(sound_file), m_decode_worker,
+                                                m_stream_buffer_policy));
+}
+
 void
 SoundManager::set_gain(float gain)
 {
@@ -202,10 +1064,24 @@ SoundManager::update(float delta)
                   return source->get_state() == SourceState::Finished;
                 });
 
+  if (m_source_events) {
+    m_source_events->dispatch();
+  }
+
   for(std::unique_ptr<SoundChannel>& channel : m_channels) {
     channel->update(delta);
   }
 
+  m_refill_scheduler->run();
+
+  update_preload_jobs();
+
+  // buffers released by sources that finished can go now
+  if (m_buffer_cache->over_budget()) {
+    m_buffer_cache->trim();
+  }
+  m_stream_hibernation->run();
+
   if (m_openal) {
     m_openal->update();
   }
@@ -18,8 +18,28 @@
 
 #include "sound_source.hpp"
 
+#include <cmath>
+#include <numbers>
+
+#include "sound_error.hpp"
+#include "sound_file.hpp"
+
 namespace wstsound {
 
+namespace {
+
+/** Gain of a fade in at 'progress', a fade out is the mirror image */
+float fade_in_gain(FadeCurve curve, float progress)
+{
+  if (curve == FadeCurve::EqualPower) {
+    return std::sin(progress * std::numbers::pi_v<float> / 2.0f);
+  } else {
+    return progress;
+  }
+}
+
+} // namespace
+
 SoundSource::SoundSource() :
   m_fade(),
   m_fade_gain(1.0f)
@@ -27,9 +47,9 @@ SoundSource::SoundSource() :
 }
 
 void
-SoundSource::set_fading(FadeDirection direction, float duration)
+SoundSource::set_fading(FadeDirection direction, float duration, FadeCurve curve)
 {
-  m_fade = Fade{direction, duration, 0.0f};
+  m_fade = Fade{direction, duration, 0.0f, curve};
 
   if (direction == FadeDirection::In) {
     m_fade_gain = 0.0f;
@@ -40,6 +60,24 @@ SoundSource::set_fading(FadeDirection direction, float duration)
   update_gain();
 }
 
+void
+SoundSource::enqueue(std::unique_ptr<SoundFile> sound_file)
+{
+  throw SoundError("SoundSource::enqueue() only supported for streaming sources");
+}
+
+void
+SoundSource::set_stem_gain(int stem, float gain)
+{
+  throw SoundError("SoundSource::set_stem_gain() only supported for stem sources");
+}
+
+void
+SoundSource::seek_to_sample_async(int64_t sample)
+{
+  seek_to_sample(sample);
+}
+
 void
 SoundSource::update(float delta)
 {
@@ -56,7 +94,7 @@ SoundSource::update(float delta)
           m_fade_gain = 1.0f;
           m_fade = std::nullopt;
         } else {
-          m_fade_gain = progress;
+          m_fade_gain = fade_in_gain(m_fade->curve, progress);
         }
       } else if (m_fade->direction == FadeDirection::Out) {
         if (progress >= 1.0f) {
@@ -64,7 +102,7 @@ SoundSource::update(float delta)
           m_fade = std::nullopt;
           finish();
         } else {
-          m_fade_gain = 1.0f - progress;
+          m_fade_gain = fade_in_gain(m_fade->curve, 1.0f - progress);
         }
       }
 
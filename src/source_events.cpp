@@ -0,0 +1,130 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "source_events.hpp"
+
+#define AL_ALEXT_PROTOTYPES
+#include <alext.h>
+
+#include "openal_system.hpp"
+
+namespace wstsound {
+
+namespace {
+
+// room for a few thousand events between two updates
+constexpr size_t QUEUE_SIZE = 4096 * sizeof(ALuint);
+
+} // namespace
+
+bool
+SourceEvents::is_supported()
+{
+  return alIsExtensionPresent("AL_SOFT_events") == AL_TRUE;
+}
+
+SourceEvents::SourceEvents() :
+  m_queue(QUEUE_SIZE),
+  m_overflow(false),
+  m_pending()
+{
+  alEventCallbackSOFT(&SourceEvents::on_event, this);
+
+  ALenum const types[] = {
+    AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT,
+    AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT
+  };
+  alEventControlSOFT(2, types, AL_TRUE);
+  OpenALSystem::check_al_error("Couldn't enable source events: ");
+}
+
+SourceEvents::~SourceEvents()
+{
+  // once the callback is replaced no more events come in for 'this'
+  ALenum const types[] = {
+    AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT,
+    AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT
+  };
+  alEventControlSOFT(2, types, AL_FALSE);
+  alEventCallbackSOFT(nullptr, nullptr);
+  OpenALSystem::warn_al_error("Couldn't disable source events: ");
+}
+
+void AL_APIENTRY
+SourceEvents::on_event(ALenum /*event_type*/, ALuint object, ALuint /*param*/,
+                       ALsizei /*length*/, ALchar const* /*message*/,
+                       void* user_param) noexcept
+{
+  SourceEvents& self = *static_cast<SourceEvents*>(user_param);
+
+  if (self.m_queue.write_available() < sizeof(object)) {
+    self.m_overflow.store(true, std::memory_order_release);
+    return;
+  }
+
+  self.m_queue.write(&object, sizeof(object));
+}
+
+void
+SourceEvents::add(ALuint source)
+{
+  // the first update() always has to look at the source
+  m_pending[source] = true;
+}
+
+void
+SourceEvents::remove(ALuint source)
+{
+  m_pending.erase(source);
+}
+
+void
+SourceEvents::dispatch()
+{
+  ALuint source = 0;
+  while (m_queue.read(&source, sizeof(source)) == sizeof(source))
+  {
+    auto it = m_pending.find(source);
+    if (it != m_pending.end()) {
+      it->second = true;
+    }
+  }
+
+  if (m_overflow.exchange(false, std::memory_order_acquire)) {
+    for(auto& it : m_pending) {
+      it.second = true;
+    }
+  }
+}
+
+bool
+SourceEvents::take(ALuint source)
+{
+  auto it = m_pending.find(source);
+  if (it == m_pending.end()) {
+    return true;
+  }
+
+  bool const pending = it->second;
+  it->second = false;
+  return pending;
+}
+
+} // namespace wstsound
+
+/* EOF */
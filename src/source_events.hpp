@@ -0,0 +1,81 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_SOURCE_EVENTS_HPP
+#define HEADER_WSTSOUND_SOURCE_EVENTS_HPP
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include <al.h>
+
+#include "ring_buffer.hpp"
+
+namespace wstsound {
+
+/** Collects buffer completed and state changed events from
+    AL_SOFT_events, so streaming sources only need to query OpenAL when
+    something happened to them. The events arrive on OpenAL's event
+    thread and are passed on through a lock-free queue. */
+class SourceEvents
+{
+public:
+  static bool is_supported();
+
+public:
+  /** Installs the event callback for the current context, there can
+      only be one SourceEvents per context */
+  SourceEvents();
+  ~SourceEvents();
+
+  void add(ALuint source);
+  void remove(ALuint source);
+
+  /** Hand the queued events out to the sources, called once per
+      SoundManager::update() */
+  void dispatch();
+
+  /** Returns true if 'source' got an event since the last call */
+  bool take(ALuint source);
+
+private:
+  static void AL_APIENTRY on_event(ALenum event_type, ALuint object, ALuint param,
+                                   ALsizei length, ALchar const* message,
+                                   void* user_param) noexcept;
+
+private:
+  RingBuffer m_queue;
+
+  /** The queue ran full, events were lost */
+  std::atomic<bool> m_overflow;
+
+  std::unordered_map<ALuint, bool> m_pending;
+
+private:
+  SourceEvents(const SourceEvents&) = delete;
+  SourceEvents& operator=(const SourceEvents&) = delete;
+};
+
+using SourceEventsPtr = std::shared_ptr<SourceEvents>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -18,13 +18,21 @@
 
 #include "static_sound_source.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include "sound_error.hpp"
 #include "sound_manager.hpp"
 
 namespace wstsound {
 
-StaticSoundSource::StaticSoundSource(SoundChannel& channel, OpenALBufferPtr buffer) :
+StaticSoundSource::StaticSoundSource(SoundChannel& channel, OpenALBufferPtr buffer,
+                                     LoopBufferFunc loop_buffer_func) :
   OpenALSoundSource(channel),
+  m_base_buffer(buffer),
   m_buffer(std::move(buffer)),
+  m_loop_buffer_func(std::move(loop_buffer_func)),
+  m_has_loop(false),
   m_duration(m_buffer->get_duration()),
   m_sample_duration(m_buffer->get_sample_duration())
 {
@@ -32,16 +40,92 @@ StaticSoundSource::StaticSoundSource(SoundChannel& channel, OpenALBufferPtr buff
   OpenALSystem::check_al_error("StaticSoundSource: ");
 }
 
-float
-StaticSoundSource::sample_to_sec(int sample) const
+void
+StaticSoundSource::set_looping(bool looping)
+{
+  if (looping && m_has_loop)
+  {
+    // back to looping the whole buffer
+    if (m_loop_buffer_func) {
+      set_buffer(m_base_buffer, std::nullopt);
+    } else {
+      set_buffer(m_buffer, std::make_pair(int64_t{0}, m_sample_duration));
+    }
+    m_has_loop = false;
+  }
+
+  OpenALSoundSource::set_looping(looping);
+}
+
+void
+StaticSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
+{
+  if (!alIsExtensionPresent("AL_SOFT_loop_points")) {
+    throw SoundError("StaticSoundSource::set_loop(): AL_SOFT_loop_points not supported");
+  }
+
+  sample_beg = std::max<int64_t>(sample_beg, 0);
+  sample_end = std::min(sample_end, m_sample_duration);
+  if (sample_beg >= sample_end) {
+    throw std::invalid_argument("StaticSoundSource::set_loop(): invalid loop range");
+  }
+
+  if (!m_loop_buffer_func) {
+    // the buffer is exclusive to this source, modify it in place
+    set_buffer(m_buffer, std::make_pair(sample_beg, sample_end));
+  } else if (sample_beg == 0 && sample_end == m_sample_duration) {
+    set_buffer(m_base_buffer, std::nullopt);
+  } else {
+    set_buffer(m_loop_buffer_func(sample_beg, sample_end), std::nullopt);
+  }
+  m_has_loop = true;
+
+  OpenALSoundSource::set_looping(true);
+}
+
+void
+StaticSoundSource::set_buffer(OpenALBufferPtr buffer, std::optional<std::pair<int64_t, int64_t>> const& loop_points)
+{
+  ALint state = AL_INITIAL;
+  alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+  ALint offset = 0;
+  alGetSourcei(m_source, AL_SAMPLE_OFFSET, &offset);
+
+  // AL_BUFFER can only be changed on a stopped source
+  bool const active = (state == AL_PLAYING || state == AL_PAUSED);
+  if (active) {
+    alSourceStop(m_source);
+  }
+
+  alSourcei(m_source, AL_BUFFER, AL_NONE);
+  if (loop_points) {
+    buffer->set_loop_points(loop_points->first, loop_points->second);
+  }
+  alSourcei(m_source, AL_BUFFER, buffer->get_handle());
+  OpenALSystem::check_al_error("StaticSoundSource::set_buffer: ");
+  m_buffer = std::move(buffer);
+
+  if (active) {
+    // the offset of a stopped source is applied on the next play
+    alSourcei(m_source, AL_SAMPLE_OFFSET, offset);
+    alSourcePlay(m_source);
+    if (state == AL_PAUSED) {
+      alSourcePause(m_source);
+    }
+    OpenALSystem::warn_al_error("StaticSoundSource::set_buffer: ");
+  }
+}
+
+double
+StaticSoundSource::sample_to_sec(int64_t sample) const
 {
-  return static_cast<float>(sample) / static_cast<float>(m_buffer->get_frequency());
+  return static_cast<double>(sample) / static_cast<double>(m_buffer->get_frequency());
 }
 
-int
-StaticSoundSource::sec_to_sample(float sec) const
+int64_t
+StaticSoundSource::sec_to_sample(double sec) const
 {
-  return static_cast<int>(sec * static_cast<float>(m_buffer->get_frequency()));
+  return static_cast<int64_t>(sec * static_cast<double>(m_buffer->get_frequency()));
 }
 
 } // namespace wstsound
@@ -19,27 +19,50 @@
 #ifndef HEADER_WINDSTILLE_SOUND_STATIC_SOUND_SOURCE_HPP
 #define HEADER_WINDSTILLE_SOUND_STATIC_SOUND_SOURCE_HPP
 
+#include <functional>
+#include <optional>
+
 #include "openal_buffer.hpp"
 #include "openal_sound_source.hpp"
 
 namespace wstsound {
 
+/** Returns a buffer with the same content and the given loop points */
+using LoopBufferFunc = std::function<OpenALBufferPtr (int64_t sample_beg, int64_t sample_end)>;
+
 class StaticSoundSource : public OpenALSoundSource
 {
 public:
-  StaticSoundSource(SoundChannel& channel, OpenALBufferPtr buffer);
+  /** 'loop_buffer_func' has to be given when 'buffer' is shared with
+      other sources, as loop points are a property of the buffer */
+  StaticSoundSource(SoundChannel& channel, OpenALBufferPtr buffer,
+                    LoopBufferFunc loop_buffer_func = {});
   ~StaticSoundSource() override {}
 
-  float get_duration() const override { return m_duration; }
-  int get_sample_duration() const override  { return m_sample_duration; }
+  void set_looping(bool looping) override;
+
+  /** Requires AL_SOFT_loop_points, playback starts at the beginning
+      and repeats sample_beg to sample_end once reaching sample_end */
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
 
-  float sample_to_sec(int sample) const override;
-  int sec_to_sample(float sec) const override;
+  double get_duration() const override { return m_duration; }
+  int64_t get_sample_duration() const override  { return m_sample_duration; }
+
+  double sample_to_sec(int64_t sample) const override;
+  int64_t sec_to_sample(double sec) const override;
+
+private:
+  /** Attach 'buffer' to the source, keeping the playback state and
+      position, loop points are applied while nothing uses it */
+  void set_buffer(OpenALBufferPtr buffer, std::optional<std::pair<int64_t, int64_t>> const& loop_points);
 
 private:
+  OpenALBufferPtr m_base_buffer;
   OpenALBufferPtr m_buffer;
-  float m_duration;
-  int m_sample_duration;
+  LoopBufferFunc m_loop_buffer_func;
+  bool m_has_loop;
+  double m_duration;
+  int64_t m_sample_duration;
 
 private:
   StaticSoundSource(const StaticSoundSource&);
@@ -0,0 +1,596 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stem_sound_source.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#include "openal_sound_source.hpp"
+#include "sound_error.hpp"
+#include "sound_file.hpp"
+#include "sound_manager.hpp"
+#include "stream_reader.hpp"
+
+namespace wstsound {
+
+/** One AL source and decoder of the group, position and state are
+    handled by the StemSoundSource */
+class StemSoundSource::Stem : public OpenALSoundSource
+{
+public:
+  Stem(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file, size_t ring_buffer_size,
+       StreamBufferPoolPtr buffer_pool_) :
+    OpenALSoundSource(channel),
+    reader(),
+    buffer_pool(std::move(buffer_pool_)),
+    format(sound_file->get_format()),
+    al_format(format.get_openal_format()),
+    buffers(),
+    free_buffers(),
+    fragment(),
+    gain(1.0f),
+    read_pos(0)
+  {
+    reader = std::make_shared<StreamReader>(std::move(sound_file), ring_buffer_size);
+  }
+
+  ~Stem() override
+  {
+    alSourceStop(m_source);
+    alSourcei(m_source, AL_BUFFER, AL_NONE);
+    for(ALuint buffer : buffers) {
+      buffer_pool->release(buffer);
+    }
+  }
+
+  ALuint get_handle() const { return m_source; }
+
+  double get_duration() const override { return reader->get_duration(); }
+  int64_t get_sample_duration() const override { return reader->get_sample_duration(); }
+
+  int64_t sec_to_sample(double sec) const override {
+    return static_cast<int64_t>(sec * static_cast<double>(format.get_rate()));
+  }
+
+  double sample_to_sec(int64_t sample) const override {
+    return static_cast<double>(sample) / static_cast<double>(format.get_rate());
+  }
+
+public:
+  StreamReaderPtr reader;
+  StreamBufferPoolPtr buffer_pool;
+  SoundFormat format;
+  ALenum al_format;
+  std::vector<ALuint> buffers;
+  std::vector<ALuint> free_buffers;
+  std::vector<char> fragment;
+  float gain;
+
+  /** Samples of the file queued so far, without padding */
+  int64_t read_pos;
+
+private:
+  Stem(const Stem&) = delete;
+  Stem& operator=(const Stem&) = delete;
+};
+
+StemSoundSource::StemSoundSource(SoundChannel& channel, std::vector<std::unique_ptr<SoundFile>> sound_files,
+                                 DecodeWorkerPtr decode_worker,
+                                 StreamBufferPolicy const& policy,
+                                 StreamBufferPoolPtr buffer_pool) :
+  m_stems(),
+  m_decode_worker(std::move(decode_worker)),
+  m_fragments(),
+  m_fragment_samples(),
+  m_rate(),
+  m_gain(1.0f),
+  m_buffers_queued(false),
+  m_restart(false),
+  m_total_samples_processed(0),
+  m_sample_duration(0),
+  m_min_sample_duration(std::numeric_limits<int64_t>::max()),
+  m_state(SourceState::Paused)
+{
+  if (sound_files.empty()) {
+    throw SoundError("StemSoundSource: no stems given");
+  }
+
+  if (!buffer_pool) {
+    buffer_pool = std::make_shared<StreamBufferPool>();
+  }
+
+  StreamBufferPolicy const fixed_policy = policy.get_fixed();
+  SoundFormat const first_format = sound_files.front()->get_format();
+  m_rate = first_format.get_rate();
+  m_fragments = fixed_policy.get_fragments();
+  m_fragment_samples = static_cast<int>(fixed_policy.get_fragment_size() / first_format.sample2bytes(1));
+
+  for(auto& sound_file : sound_files)
+  {
+    SoundFormat const format = sound_file->get_format();
+    if (format.get_rate() != m_rate) {
+      throw SoundError("StemSoundSource: all stems must have the same sample rate");
+    }
+
+    m_sample_duration = std::max(m_sample_duration, sound_file->get_sample_duration());
+    m_min_sample_duration = std::min(m_min_sample_duration, sound_file->get_sample_duration());
+
+    size_t const ring_buffer_size = m_decode_worker ? fixed_policy.get_max_bytes(format) : 0;
+    auto stem = std::make_unique<Stem>(channel, std::move(sound_file), ring_buffer_size, buffer_pool);
+
+    for(int i = 0; i < m_fragments; ++i) {
+      stem->buffers.emplace_back(buffer_pool->acquire());
+    }
+
+    if (stem->reader->is_threaded()) {
+      // a fragment can't be larger than what the reader can buffer
+      m_fragment_samples = std::min(m_fragment_samples,
+                                    static_cast<int>(stem->reader->get_buffer_capacity() / 2 /
+                                                     format.sample2bytes(1)));
+    }
+
+    m_stems.emplace_back(std::move(stem));
+  }
+
+  if (m_decode_worker) {
+    for(auto& stem : m_stems) {
+      m_decode_worker->add(stem->reader);
+    }
+  }
+}
+
+StemSoundSource::~StemSoundSource()
+{
+  if (m_decode_worker) {
+    for(auto& stem : m_stems) {
+      stem->reader->cancel();
+      m_decode_worker->remove(stem->reader);
+    }
+  }
+
+  clear_queue();
+}
+
+std::vector<ALuint>
+StemSoundSource::get_handles() const
+{
+  std::vector<ALuint> handles;
+  for(auto const& stem : m_stems) {
+    handles.emplace_back(stem->get_handle());
+  }
+  return handles;
+}
+
+void
+StemSoundSource::play()
+{
+  if (m_state == SourceState::Playing) { return; }
+
+  m_state = SourceState::Playing;
+
+  if (!m_buffers_queued) {
+    for(auto& stem : m_stems) {
+      if (stem->reader->is_threaded()) {
+        stem->reader->fill();
+      }
+    }
+  }
+
+  update_queue();
+
+  ALint queued = 0;
+  alGetSourcei(m_stems.front()->get_handle(), AL_BUFFERS_QUEUED, &queued);
+  if (queued == 0) {
+    // the decoder is not ready yet, update() starts the sources
+    m_restart = true;
+  } else {
+    auto const handles = get_handles();
+    alSourcePlayv(static_cast<ALsizei>(handles.size()), handles.data());
+    OpenALSystem::warn_al_error("Couldn't start audio sources: ");
+    m_restart = false;
+  }
+}
+
+void
+StemSoundSource::pause()
+{
+  if (m_state == SourceState::Paused) { return; }
+
+  m_state = SourceState::Paused;
+
+  auto const handles = get_handles();
+  alSourcePausev(static_cast<ALsizei>(handles.size()), handles.data());
+  OpenALSystem::warn_al_error("Couldn't pause audio sources: ");
+}
+
+void
+StemSoundSource::finish()
+{
+  if (m_state == SourceState::Finished) { return; }
+
+  m_state = SourceState::Finished;
+
+  clear_queue();
+}
+
+double
+StemSoundSource::get_duration() const
+{
+  return sample_to_sec(m_sample_duration);
+}
+
+void
+StemSoundSource::set_looping(bool looping)
+{
+  for(auto& stem : m_stems) {
+    if (looping) {
+      stem->reader->set_loop(StreamReader::Loop{0, m_min_sample_duration});
+    } else {
+      stem->reader->set_loop(std::nullopt);
+    }
+  }
+}
+
+void
+StemSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
+{
+  if (sample_beg > sample_end) {
+    throw std::invalid_argument("StemSoundSource::set_loop(): invalid loop range");
+  }
+
+  for(auto& stem : m_stems) {
+    stem->reader->set_loop(StreamReader::Loop{
+        std::max<int64_t>(sample_beg, 0),
+        std::min(sample_end, m_min_sample_duration)
+      });
+  }
+}
+
+void
+StemSoundSource::set_gain(float gain)
+{
+  m_gain = gain;
+  update_gain();
+}
+
+void
+StemSoundSource::set_stem_gain(int stem, float gain)
+{
+  if (stem < 0 || stem >= static_cast<int>(m_stems.size())) {
+    throw std::out_of_range("StemSoundSource::set_stem_gain(): invalid stem");
+  }
+
+  m_stems[static_cast<size_t>(stem)]->gain = gain;
+  update_gain();
+}
+
+void
+StemSoundSource::set_pitch(float pitch)
+{
+  for(auto& stem : m_stems) {
+    stem->set_pitch(pitch);
+  }
+}
+
+void
+StemSoundSource::seek_to(double sec)
+{
+  seek_to_sample(sec_to_sample(sec));
+}
+
+void
+StemSoundSource::seek_to_sample(int64_t sample)
+{
+  clear_queue();
+
+  for(auto& stem : m_stems) {
+    stem->reader->seek_to_sample(sample);
+    stem->read_pos = sample;
+  }
+  m_total_samples_processed = sample;
+
+  if (m_state == SourceState::Playing) {
+    m_restart = true;
+  }
+}
+
+int64_t
+StemSoundSource::get_stem_read_pos(int stem) const
+{
+  if (stem < 0 || stem >= static_cast<int>(m_stems.size())) {
+    throw std::out_of_range("StemSoundSource::get_stem_read_pos(): invalid stem");
+  }
+
+  return m_stems[static_cast<size_t>(stem)]->read_pos;
+}
+
+double
+StemSoundSource::get_pos() const
+{
+  return sample_to_sec(get_sample_pos());
+}
+
+int64_t
+StemSoundSource::get_sample_pos() const
+{
+  ALint sample_offset = 0;
+  alGetSourcei(m_stems.front()->get_handle(), AL_SAMPLE_OFFSET, &sample_offset);
+
+  return m_total_samples_processed + sample_offset;
+}
+
+void
+StemSoundSource::set_relative(bool relative)
+{
+  for(auto& stem : m_stems) {
+    stem->set_relative(relative);
+  }
+}
+
+void
+StemSoundSource::set_position(float x, float y, float z)
+{
+  for(auto& stem : m_stems) {
+    stem->set_position(x, y, z);
+  }
+}
+
+void
+StemSoundSource::set_velocity(float x, float y, float z)
+{
+  for(auto& stem : m_stems) {
+    stem->set_velocity(x, y, z);
+  }
+}
+
+void
+StemSoundSource::set_reference_distance(float distance)
+{
+  for(auto& stem : m_stems) {
+    stem->set_reference_distance(distance);
+  }
+}
+
+void
+StemSoundSource::set_rolloff_factor(float factor)
+{
+  for(auto& stem : m_stems) {
+    stem->set_rolloff_factor(factor);
+  }
+}
+
+void
+StemSoundSource::set_direct_filter(FilterPtr const& filter)
+{
+  for(auto& stem : m_stems) {
+    stem->set_direct_filter(filter);
+  }
+}
+
+void
+StemSoundSource::set_effect_slot(EffectSlotPtr const& slot, FilterPtr const& filter)
+{
+  for(auto& stem : m_stems) {
+    stem->set_effect_slot(slot, filter);
+  }
+}
+
+void
+StemSoundSource::update_gain() const
+{
+  // AL_GAIN is applied per source, so changing it doesn't touch the timing
+  for(auto const& stem : m_stems) {
+    stem->set_gain(m_gain * stem->gain * m_fade_gain);
+  }
+}
+
+void
+StemSoundSource::update(float delta)
+{
+  SoundSource::update(delta);
+
+  if (m_state != SourceState::Playing) { return; }
+
+  if (m_buffers_queued && !m_restart)
+  {
+    // all stems run dry at the same time, if one stopped stop all of
+    // them and restart them together once there is new data
+    for(auto const& stem : m_stems)
+    {
+      ALint state = AL_STOPPED;
+      alGetSourcei(stem->get_handle(), AL_SOURCE_STATE, &state);
+      if (state == AL_STOPPED)
+      {
+        std::cerr << "Restarting stem sources because of buffer underrun.\n";
+        auto const handles = get_handles();
+        alSourceStopv(static_cast<ALsizei>(handles.size()), handles.data());
+        m_restart = true;
+        break;
+      }
+    }
+  }
+
+  update_queue();
+
+  ALint queued = 0;
+  alGetSourcei(m_stems.front()->get_handle(), AL_BUFFERS_QUEUED, &queued);
+  if (queued == 0)
+  {
+    bool const eof = std::all_of(m_stems.begin(), m_stems.end(),
+                                 [](auto const& stem) { return stem->reader->eof(); });
+    if (eof) {
+      m_state = SourceState::Finished;
+      m_restart = false;
+      clear_queue();
+    }
+  }
+  else if (m_restart)
+  {
+    auto const handles = get_handles();
+    alSourcePlayv(static_cast<ALsizei>(handles.size()), handles.data());
+    OpenALSystem::warn_al_error("Couldn't start audio sources: ");
+    m_restart = false;
+  }
+}
+
+int64_t
+StemSoundSource::sec_to_sample(double sec) const
+{
+  return static_cast<int64_t>(sec * static_cast<double>(m_rate));
+}
+
+double
+StemSoundSource::sample_to_sec(int64_t sample) const
+{
+  return static_cast<double>(sample) / static_cast<double>(m_rate);
+}
+
+bool
+StemSoundSource::fill_fragment()
+{
+  // update_queue() made sure every stem can deliver a whole fragment
+  // or is at its end, so only stems that ended come up short
+  std::vector<size_t> bytesread(m_stems.size());
+  int frames = 0;
+  for(size_t i = 0; i < m_stems.size(); ++i)
+  {
+    Stem& stem = *m_stems[i];
+    stem.fragment.resize(stem.format.sample2bytes(m_fragment_samples));
+
+    // a synchronous reader returns early at a loop wrap
+    while (bytesread[i] < stem.fragment.size()) {
+      size_t const len = stem.reader->read(stem.fragment.data() + bytesread[i],
+                                           stem.fragment.size() - bytesread[i]);
+      if (len == 0) { break; }
+      bytesread[i] += len;
+    }
+
+    int64_t const stem_frames = static_cast<int64_t>(bytesread[i] / stem.format.sample2bytes(1));
+    stem.read_pos += stem_frames;
+    frames = std::max(frames, static_cast<int>(stem_frames));
+  }
+
+  if (frames == 0) {
+    return false;
+  }
+
+  if (m_decode_worker) {
+    m_decode_worker->notify();
+  }
+
+  for(size_t i = 0; i < m_stems.size(); ++i)
+  {
+    Stem& stem = *m_stems[i];
+    size_t const size = stem.format.sample2bytes(frames);
+
+    // stems that already ended are padded with silence
+    std::fill(stem.fragment.begin() + static_cast<std::ptrdiff_t>(bytesread[i]),
+              stem.fragment.begin() + static_cast<std::ptrdiff_t>(size),
+              static_cast<char>(stem.format.get_bits_per_sample() == 8 ? 0x80 : 0));
+
+    ALuint buffer = stem.free_buffers.back();
+    alBufferData(buffer, stem.al_format, stem.fragment.data(), static_cast<ALsizei>(size), m_rate);
+    OpenALSystem::check_al_error("Couldn't refill audio buffer: ");
+
+    alSourceQueueBuffers(stem.get_handle(), 1, &buffer);
+    OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+
+    stem.free_buffers.pop_back();
+  }
+
+  return true;
+}
+
+void
+StemSoundSource::update_queue()
+{
+  if (m_state != SourceState::Playing) { return; }
+
+  if (!m_buffers_queued)
+  {
+    for(auto& stem : m_stems) {
+      stem->free_buffers.assign(stem->buffers.rbegin(), stem->buffers.rend());
+    }
+    m_buffers_queued = true;
+  }
+  else
+  {
+    // the stems are mixed in the same update, only take what all of
+    // them are done with to keep the queues the same length
+    ALint processed = std::numeric_limits<ALint>::max();
+    for(auto const& stem : m_stems) {
+      ALint stem_processed = 0;
+      alGetSourcei(stem->get_handle(), AL_BUFFERS_PROCESSED, &stem_processed);
+      processed = std::min(processed, stem_processed);
+    }
+
+    for(auto& stem : m_stems)
+    {
+      std::vector<ALuint> unqueue_buffers(static_cast<size_t>(processed));
+      alSourceUnqueueBuffers(stem->get_handle(), processed, unqueue_buffers.data());
+      OpenALSystem::warn_al_error("Couldn't unqueue audio buffer: ");
+
+      if (stem == m_stems.front()) {
+        for(ALuint buffer : unqueue_buffers) {
+          ALint size = 0;
+          alGetBufferi(buffer, AL_SIZE, &size);
+          m_total_samples_processed += size / static_cast<ALint>(stem->format.sample2bytes(1));
+        }
+      }
+
+      stem->free_buffers.insert(stem->free_buffers.end(), unqueue_buffers.begin(), unqueue_buffers.end());
+    }
+  }
+
+  while (!m_stems.front()->free_buffers.empty())
+  {
+    // also with an empty queue, e.g. on the first play, after a seek
+    // or an underrun: a stem that is behind would otherwise get padded
+    // and stay offset for good
+    bool const ready = std::all_of(m_stems.begin(), m_stems.end(), [this](auto const& stem) {
+      return stem->reader->ready(stem->format.sample2bytes(m_fragment_samples)) || stem->reader->eof();
+    });
+    if (!ready) { break; }
+
+    if (!fill_fragment()) {
+      break;
+    }
+  }
+}
+
+void
+StemSoundSource::clear_queue()
+{
+  if (!m_buffers_queued) { return; }
+
+  auto const handles = get_handles();
+  alSourceStopv(static_cast<ALsizei>(handles.size()), handles.data());
+
+  for(auto& stem : m_stems) {
+    alSourcei(stem->get_handle(), AL_BUFFER, AL_NONE);
+    stem->free_buffers.clear();
+  }
+  m_buffers_queued = false;
+}
+
+} // namespace wstsound
+
+/* EOF */
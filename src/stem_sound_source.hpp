@@ -0,0 +1,129 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_STEM_SOUND_SOURCE_HPP
+#define HEADER_WSTSOUND_STEM_SOUND_SOURCE_HPP
+
+#include <memory>
+#include <vector>
+
+#include <al.h>
+
+#include "decode_worker.hpp"
+#include "sound_source.hpp"
+#include "stream_buffer_policy.hpp"
+#include "stream_buffer_pool.hpp"
+
+namespace wstsound {
+
+class SoundChannel;
+class SoundFile;
+
+/** Streams multiple SoundFiles of the same sample rate in lockstep,
+    e.g. the stems of an adaptive music track. Every AL buffer queue
+    gets fragments of identical length and all sources are started and
+    stopped together, so the stems never drift apart. */
+class StemSoundSource : public SoundSource
+{
+public:
+  StemSoundSource(SoundChannel& channel, std::vector<std::unique_ptr<SoundFile>> sound_files,
+                  DecodeWorkerPtr decode_worker = {},
+                  StreamBufferPolicy const& policy = {},
+                  StreamBufferPoolPtr buffer_pool = {});
+  ~StemSoundSource() override;
+
+  void play() override;
+  void pause() override;
+  void finish() override;
+
+  SourceState get_state() const override { return m_state; }
+
+  double get_duration() const override;
+  int64_t get_sample_duration() const override { return m_sample_duration; }
+
+  /** Loops apply to all stems, the end is clamped to the shortest one */
+  void set_looping(bool looping) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
+
+  void set_gain(float gain) override;
+  float get_gain() const override { return m_gain; }
+  void set_stem_gain(int stem, float gain) override;
+  void set_pitch(float pitch) override;
+
+  void seek_to(double sec) override;
+  void seek_to_sample(int64_t sample) override;
+
+  /** Samples of stem 'stem' queued so far, the same for all stems
+      that haven't ended */
+  int64_t get_stem_read_pos(int stem) const;
+
+  double get_pos() const override;
+  int64_t get_sample_pos() const override;
+
+  void set_relative(bool relative) override;
+  void set_position(float x, float y, float z) override;
+  void set_velocity(float x, float y, float z) override;
+  void set_reference_distance(float distance) override;
+  void set_rolloff_factor(float factor) override;
+
+  void set_direct_filter(FilterPtr const& filter) override;
+  void set_effect_slot(EffectSlotPtr const& slot, FilterPtr const& filter = {}) override;
+
+  void update_gain() const override;
+
+  void update(float delta) override;
+
+  int64_t sec_to_sample(double sec) const override;
+  double sample_to_sec(int64_t sample) const override;
+
+private:
+  class Stem;
+
+  /** Read one fragment from every stem and queue it, returns false
+      when all stems are exhausted */
+  bool fill_fragment();
+  void update_queue();
+  void clear_queue();
+  std::vector<ALuint> get_handles() const;
+
+private:
+  std::vector<std::unique_ptr<Stem>> m_stems;
+  DecodeWorkerPtr m_decode_worker;
+  int m_fragments;
+  int m_fragment_samples;
+  int m_rate;
+  float m_gain;
+  bool m_buffers_queued;
+
+  /** Sources need to be (re)started with alSourcePlayv() */
+  bool m_restart;
+  int64_t m_total_samples_processed;
+  int64_t m_sample_duration;
+  int64_t m_min_sample_duration;
+  SourceState m_state;
+
+public:
+  StemSoundSource(const StemSoundSource&) = delete;
+  StemSoundSource& operator=(const StemSoundSource&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
@@ -0,0 +1,85 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_buffer_policy.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "sound_format.hpp"
+
+namespace wstsound {
+
+StreamBufferPolicy
+StreamBufferPolicy::fixed(int fragments, size_t fragment_size)
+{
+  if (fragments < 2 || fragment_size == 0) {
+    throw std::invalid_argument("StreamBufferPolicy::fixed(): need at least two non-empty fragments");
+  }
+
+  StreamBufferPolicy policy;
+  policy.m_fragments = fragments;
+  policy.m_fragment_size = fragment_size;
+  return policy;
+}
+
+StreamBufferPolicy
+StreamBufferPolicy::adaptive(float min_latency, float max_latency)
+{
+  if (min_latency <= 0.0f || min_latency > max_latency) {
+    throw std::invalid_argument("StreamBufferPolicy::adaptive(): invalid latency range");
+  }
+
+  StreamBufferPolicy policy;
+  policy.m_adaptive = true;
+  policy.m_min_latency = min_latency;
+  policy.m_max_latency = max_latency;
+  return policy;
+}
+
+StreamBufferPolicy::StreamBufferPolicy() :
+  m_adaptive(false),
+  m_fragments(4),
+  m_fragment_size(65536),
+  m_min_latency(0.0f),
+  m_max_latency(0.0f)
+{
+}
+
+StreamBufferPolicy
+StreamBufferPolicy::get_fixed() const
+{
+  return m_adaptive ? StreamBufferPolicy() : *this;
+}
+
+size_t
+StreamBufferPolicy::get_max_bytes(SoundFormat const& format) const
+{
+  if (!m_adaptive) {
+    return m_fragments * m_fragment_size;
+  } else {
+    size_t const bytes = format.sample2bytes(static_cast<int>(m_max_latency * static_cast<float>(format.get_rate())));
+    return std::clamp(bytes,
+                      MIN_FRAGMENTS * MIN_FRAGMENT_SIZE,
+                      MAX_FRAGMENTS * MAX_FRAGMENT_SIZE);
+  }
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,79 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_buffer_pool.hpp"
+
+#include <algorithm>
+
+#include "openal_system.hpp"
+
+namespace wstsound {
+
+StreamBufferPool::StreamBufferPool() :
+  m_free(),
+  m_size(0),
+  m_high_water_mark(0)
+{
+}
+
+StreamBufferPool::~StreamBufferPool()
+{
+  // sources hold on to the pool, so all buffers are back by now
+  if (m_free.empty()) { return; }
+
+  alDeleteBuffers(static_cast<ALsizei>(m_free.size()), m_free.data());
+  OpenALSystem::warn_al_error("Couldn't delete audio buffers: ");
+}
+
+ALuint
+StreamBufferPool::acquire()
+{
+  if (m_free.empty()) {
+    reserve(m_size + 1);
+  }
+
+  ALuint const buffer = m_free.back();
+  m_free.pop_back();
+
+  m_high_water_mark = std::max(m_high_water_mark, get_in_use());
+
+  return buffer;
+}
+
+void
+StreamBufferPool::release(ALuint buffer)
+{
+  m_free.emplace_back(buffer);
+}
+
+void
+StreamBufferPool::reserve(size_t count)
+{
+  if (count <= m_size) { return; }
+
+  std::vector<ALuint> buffers(count - m_size);
+  alGenBuffers(static_cast<ALsizei>(buffers.size()), buffers.data());
+  OpenALSystem::check_al_error("Couldn't allocate audio buffers: ");
+
+  m_free.insert(m_free.begin(), buffers.begin(), buffers.end());
+  m_size = count;
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,75 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_STREAM_BUFFER_POOL_HPP
+#define HEADER_WSTSOUND_STREAM_BUFFER_POOL_HPP
+
+#include <memory>
+#include <stddef.h>
+#include <vector>
+
+#include <al.h>
+
+namespace wstsound {
+
+/** AL buffers shared by the streaming sources, so creating and
+    destroying a stream doesn't allocate buffers in the driver. The
+    pool grows to the peak number of buffers in use and keeps them
+    until it is destroyed. */
+class StreamBufferPool
+{
+public:
+  StreamBufferPool();
+  ~StreamBufferPool();
+
+  /** Returns an unused buffer, allocating a new one when the pool is
+      empty */
+  ALuint acquire();
+
+  /** Return 'buffer' to the pool, it must not be queued on a source */
+  void release(ALuint buffer);
+
+  /** Allocate buffers up front until the pool holds 'count' */
+  void reserve(size_t count);
+
+  /** Number of buffers allocated */
+  size_t get_size() const { return m_size; }
+
+  /** Number of buffers currently lent out */
+  size_t get_in_use() const { return m_size - m_free.size(); }
+
+  /** Highest number of buffers that were lent out at once */
+  size_t get_high_water_mark() const { return m_high_water_mark; }
+
+private:
+  std::vector<ALuint> m_free;
+  size_t m_size;
+  size_t m_high_water_mark;
+
+private:
+  StreamBufferPool(const StreamBufferPool&) = delete;
+  StreamBufferPool& operator=(const StreamBufferPool&) = delete;
+};
+
+using StreamBufferPoolPtr = std::shared_ptr<StreamBufferPool>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
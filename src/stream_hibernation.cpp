@@ -0,0 +1,81 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_hibernation.hpp"
+
+#include <algorithm>
+
+namespace wstsound {
+
+StreamHibernation::StreamHibernation() :
+  m_idle_timeout(0.0f),
+  m_max_open(0),
+  m_open()
+{
+}
+
+void
+StreamHibernation::opened(Client& client)
+{
+  if (std::find(m_open.begin(), m_open.end(), &client) == m_open.end()) {
+    m_open.emplace_back(&client);
+  }
+}
+
+void
+StreamHibernation::closed(Client& client)
+{
+  std::erase(m_open, &client);
+}
+
+void
+StreamHibernation::run()
+{
+  if (!is_enabled()) { return; }
+
+  // hibernate() calls closed(), so work on a copy
+  std::vector<Client*> clients = m_open;
+
+  if (m_idle_timeout > 0.0f) {
+    for(Client* client : clients) {
+      if (client->get_idle_time() >= m_idle_timeout) {
+        client->hibernate();
+      }
+    }
+  }
+
+  if (m_max_open > 0 && m_open.size() > m_max_open)
+  {
+    clients = m_open;
+    std::sort(clients.begin(), clients.end(),
+              [](Client const* lhs, Client const* rhs) {
+                return lhs->get_idle_time() > rhs->get_idle_time();
+              });
+
+    for(Client* client : clients) {
+      if (m_open.size() <= m_max_open || client->get_idle_time() <= 0.0f) {
+        break;
+      }
+      client->hibernate();
+    }
+  }
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,88 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_STREAM_HIBERNATION_HPP
+#define HEADER_WSTSOUND_STREAM_HIBERNATION_HPP
+
+#include <memory>
+#include <stddef.h>
+#include <vector>
+
+namespace wstsound {
+
+/** Tracks the streams that have their decoder open and puts those
+    that were paused or inaudible for too long to sleep, releasing
+    their decoder, file handle and AL buffers. A sleeping stream only
+    remembers its position and reopens the file when it is needed
+    again. */
+class StreamHibernation
+{
+public:
+  class Client
+  {
+  public:
+    virtual ~Client() {}
+
+    /** Seconds the stream has been paused or inaudible, 0 while it
+        is audible */
+    virtual float get_idle_time() const = 0;
+
+    /** Release the decoder, returns false if the stream can't */
+    virtual bool hibernate() = 0;
+  };
+
+public:
+  StreamHibernation();
+
+  /** Hibernate streams idle for longer than 'seconds', 0 disables */
+  void set_idle_timeout(float seconds) { m_idle_timeout = seconds; }
+  float get_idle_timeout() const { return m_idle_timeout; }
+
+  /** Hibernate the longest idle streams while more than 'count'
+      decoders are open, 0 means no limit. Audible streams are never
+      hibernated, so the limit can be exceeded. */
+  void set_max_open(size_t count) { m_max_open = count; }
+  size_t get_max_open() const { return m_max_open; }
+
+  bool is_enabled() const { return m_idle_timeout > 0.0f || m_max_open > 0; }
+
+  void opened(Client& client);
+  void closed(Client& client);
+
+  size_t get_open_count() const { return m_open.size(); }
+
+  /** Called once per SoundManager::update() */
+  void run();
+
+private:
+  float m_idle_timeout;
+  size_t m_max_open;
+  std::vector<Client*> m_open;
+
+private:
+  StreamHibernation(const StreamHibernation&) = delete;
+  StreamHibernation& operator=(const StreamHibernation&) = delete;
+};
+
+using StreamHibernationPtr = std::shared_ptr<StreamHibernation>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
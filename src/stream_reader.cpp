@@ -0,0 +1,761 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_reader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numbers>
+
+#include "sound_error.hpp"
+#include "sound_file.hpp"
+
+namespace wstsound {
+
+namespace {
+
+/** Mix 'out' into 'in' with an equal-power curve, 'pos' and
+    'duration' give the position of the first frame in the fade */
+void mix_equal_power(int16_t* in, int16_t const* out, int frames, int channels,
+                     int pos, int duration)
+{
+  for(int i = 0; i < frames; ++i)
+  {
+    float const progress = static_cast<float>(pos + i) / static_cast<float>(duration);
+    float const in_gain = std::sin(progress * std::numbers::pi_v<float> / 2.0f);
+    float const out_gain = std::cos(progress * std::numbers::pi_v<float> / 2.0f);
+
+    for(int c = 0; c < channels; ++c) {
+      int const idx = i * channels + c;
+      float const value = static_cast<float>(in[idx]) * in_gain +
+                          static_cast<float>(out[idx]) * out_gain;
+      in[idx] = static_cast<int16_t>(std::clamp(value, -32768.0f, 32767.0f));
+    }
+  }
+}
+
+/** Copy of 'ring' with 'capacity', requires both of its sides to be
+    idle */
+std::unique_ptr<RingBuffer>
+grow_ring_buffer(RingBuffer& ring, size_t capacity)
+{
+  auto result = std::make_unique<RingBuffer>(capacity);
+
+  std::vector<char> data(ring.read_available());
+  ring.read(data.data(), data.size());
+  result->write(data.data(), data.size());
+
+  return result;
+}
+
+} // namespace
+
+StreamReader::StreamReader(std::unique_ptr<SoundFile> sound_file, size_t ring_buffer_size) :
+  m_mutex(),
+  m_sound_file(std::move(sound_file)),
+  m_next_files(),
+  m_format(m_sound_file->get_format()),
+  m_sample_duration(m_sound_file->get_sample_duration()),
+  m_frame_size(m_format.sample2bytes(1)),
+  m_loop(),
+  m_loop_crossfade(0),
+  m_loop_head(),
+  m_loop_head_pos(),
+  m_loop_tail(),
+  m_loop_seek(),
+  m_crossfade(),
+  m_mix(),
+  m_samples_produced(0),
+  m_transitions_mutex(),
+  m_transitions(),
+  m_ring_buffer_size(ring_buffer_size),
+  m_ring_mutex(),
+  m_ring_buffer(),
+  m_eof(false),
+  m_cancelled(false),
+  m_open(true),
+  m_seek_ring(),
+  m_seek_request(-1),
+  m_seek_target(0),
+  m_seeking(false),
+  m_seek_pending(false),
+  m_seek_ready(false)
+{
+  if (ring_buffer_size > 0) {
+    // whole frames only, so the write spans of the ring stay aligned
+    m_ring_buffer_size = std::max(ring_buffer_size - ring_buffer_size % m_frame_size, m_frame_size);
+    m_ring_buffer = std::make_unique<RingBuffer>(m_ring_buffer_size);
+  }
+}
+
+StreamReader::~StreamReader()
+{
+}
+
+double
+StreamReader::get_duration() const
+{
+  return static_cast<double>(m_sample_duration) / static_cast<double>(m_format.get_rate());
+}
+
+size_t
+StreamReader::read(void* buffer, size_t buffer_size)
+{
+  buffer_size -= buffer_size % m_frame_size;
+
+  if (!is_threaded())
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_sound_file) { return 0; }
+    return decode(buffer, buffer_size);
+  }
+  else
+  {
+    // might run on the mixer thread, so don't wait for a swap of the
+    // ring, the caller sees a short read instead
+    std::unique_lock<std::mutex> lock(m_ring_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || !m_ring_buffer) { return 0; }
+
+    size_t const len = std::min(buffer_size, m_ring_buffer->read_available());
+    return m_ring_buffer->read(buffer, len - len % m_frame_size);
+  }
+}
+
+bool
+StreamReader::ready(size_t size) const
+{
+  if (!is_threaded()) {
+    return true;
+  }
+
+  // a closed reader returns nothing, but without waiting
+  std::lock_guard<std::mutex> lock(m_ring_mutex);
+  if (!m_ring_buffer) {
+    return true;
+  } else {
+    return m_eof || m_ring_buffer->read_available() >= size;
+  }
+}
+
+bool
+StreamReader::eof() const
+{
+  if (!is_threaded()) {
+    return m_eof;
+  }
+
+  // like read(), a swap in progress isn't worth waiting for
+  std::unique_lock<std::mutex> lock(m_ring_mutex, std::try_to_lock);
+  if (!lock.owns_lock() || !m_ring_buffer) {
+    return false;
+  } else {
+    // while a seek is pending m_eof refers to the new position
+    return !m_seek_pending && m_eof && m_ring_buffer->read_available() == 0;
+  }
+}
+
+bool
+StreamReader::fill()
+{
+  if (m_ring_buffer_size == 0 || m_cancelled) { return false; }
+  if (m_eof && m_seek_request < 0) { return false; }
+
+  std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+  if (!lock.owns_lock()) { return false; }
+
+  return fill_chunk();
+}
+
+bool
+StreamReader::fill_wait()
+{
+  if (m_ring_buffer_size == 0 || m_cancelled) { return false; }
+  if (m_eof && m_seek_request < 0) { return false; }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return fill_chunk();
+}
+
+bool
+StreamReader::fill_chunk()
+{
+  // closed while the worker was on its way here
+  if (!m_sound_file) { return false; }
+
+  if (m_seek_request >= 0 || m_seeking) {
+    return fill_seek();
+  }
+
+  // the SoundFile is already positioned for the pending seek
+  if (m_seek_ready || m_eof) { return false; }
+
+  // decode in place, the ring is the only copy before the mixer
+  std::span<char> const span = m_ring_buffer->write_span();
+  size_t len = std::min(span.size(), FILLCHUNKSIZE);
+  len -= len % m_frame_size;
+  if (len == 0) { return false; }
+
+  try {
+    size_t const bytesread = decode(span.data(), len);
+    m_ring_buffer->commit(bytesread);
+    return bytesread > 0;
+  } catch(std::exception const& err) {
+    std::cerr << "StreamReader::fill(): decode failure: " << err.what() << std::endl;
+    m_eof = true;
+    return false;
+  }
+}
+
+bool
+StreamReader::fill_seek()
+{
+  int64_t const request = m_seek_request.exchange(-1);
+  if (request >= 0) {
+    // a newer request invalidates whatever was decoded for an older one
+    m_seek_ready = false;
+    m_seek_ring->clear();
+    m_seek_target = request;
+    m_seeking = true;
+
+    m_loop_head_pos = std::nullopt;
+    m_loop_tail.clear();
+    m_loop_seek = std::nullopt;
+
+    try {
+      m_sound_file->seek_to_sample(request);
+    } catch(std::exception const& err) {
+      std::cerr << "StreamReader::fill(): seek failure: " << err.what() << std::endl;
+      m_seeking = false;
+      m_seek_ready = true;
+      m_eof = true;
+      return false;
+    }
+    m_samples_produced = request;
+    m_eof = false;
+  }
+
+  if (!m_seeking) { return false; }
+
+  // decode half a ring ahead before handing over, so the swap doesn't
+  // immediately run into an underrun
+  size_t const preroll = m_seek_ring->capacity() / 2;
+
+  if (!m_eof && m_seek_ring->read_available() < preroll) {
+    std::span<char> const span = m_seek_ring->write_span();
+    size_t len = std::min(span.size(), FILLCHUNKSIZE);
+    len -= len % m_frame_size;
+    try {
+      size_t const bytesread = decode(span.data(), len);
+      m_seek_ring->commit(bytesread);
+    } catch(std::exception const& err) {
+      std::cerr << "StreamReader::fill(): decode failure: " << err.what() << std::endl;
+      m_eof = true;
+    }
+  }
+
+  if (m_eof || m_seek_ring->read_available() >= preroll) {
+    m_seeking = false;
+    m_seek_ready = true;
+  }
+
+  return true;
+}
+
+void
+StreamReader::seek_to_sample(int64_t sample)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // a synchronous seek overrides any pending asynchronous one
+  m_seek_request = -1;
+  m_seeking = false;
+  m_seek_ready = false;
+  m_seek_pending = false;
+
+  m_loop_head_pos = std::nullopt;
+  m_loop_tail.clear();
+  m_loop_seek = std::nullopt;
+
+  m_sound_file->seek_to_sample(sample);
+  {
+    std::lock_guard<std::mutex> ring_lock(m_ring_mutex);
+    if (m_ring_buffer) {
+      m_ring_buffer->clear();
+    }
+  }
+  m_samples_produced = sample;
+  m_eof = false;
+
+  std::lock_guard<std::mutex> transitions_lock(m_transitions_mutex);
+  m_transitions.clear();
+}
+
+void
+StreamReader::request_seek(int64_t sample)
+{
+  if (m_ring_buffer_size == 0) {
+    throw SoundError("StreamReader::request_seek(): reader is not threaded");
+  }
+
+  if (!m_seek_ring) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_seek_ring = std::make_unique<RingBuffer>(m_ring_buffer_size);
+  }
+
+  m_seek_pending = true;
+  m_seek_request = std::max<int64_t>(0, sample);
+}
+
+int64_t
+StreamReader::complete_seek()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::unique_lock<std::mutex> ring_lock(m_ring_mutex);
+
+  std::swap(m_ring_buffer, m_seek_ring);
+  ring_lock.unlock();
+
+  m_seek_ring->clear();
+  m_seek_ready = false;
+  m_seek_pending = m_seek_request >= 0;
+
+  // transitions recorded so far belong to the data that was dropped
+  std::lock_guard<std::mutex> transitions_lock(m_transitions_mutex);
+  m_transitions.clear();
+
+  return m_seek_target;
+}
+
+void
+StreamReader::close()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_open = false;
+  m_sound_file.reset();
+  m_next_files.clear();
+  m_crossfade.reset();
+  m_mix = {};
+
+  m_loop_head = {};
+  m_loop_head_pos = std::nullopt;
+  m_loop_tail = {};
+  m_loop_seek = std::nullopt;
+
+  {
+    std::lock_guard<std::mutex> ring_lock(m_ring_mutex);
+    m_ring_buffer.reset();
+  }
+  m_seek_ring.reset();
+
+  m_seek_request = -1;
+  m_seeking = false;
+  m_seek_ready = false;
+  m_seek_pending = false;
+  m_eof = false;
+
+  std::lock_guard<std::mutex> transitions_lock(m_transitions_mutex);
+  m_transitions.clear();
+}
+
+void
+StreamReader::reopen(std::unique_ptr<SoundFile> sound_file, int64_t sample)
+{
+  SoundFormat const format = sound_file->get_format();
+  if (format.get_rate() != m_format.get_rate() ||
+      format.get_channels() != m_format.get_channels() ||
+      format.get_bits_per_sample() != m_format.get_bits_per_sample()) {
+    throw SoundError("StreamReader::reopen(): format of the file changed");
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_sound_file = std::move(sound_file);
+  m_sound_file->seek_to_sample(sample);
+  m_samples_produced = sample;
+  m_eof = false;
+
+  if (m_ring_buffer_size > 0) {
+    auto ring_buffer = std::make_unique<RingBuffer>(m_ring_buffer_size);
+    std::lock_guard<std::mutex> ring_lock(m_ring_mutex);
+    m_ring_buffer = std::move(ring_buffer);
+  }
+
+  m_open = true;
+}
+
+void
+StreamReader::grow_buffer_capacity(size_t bytes)
+{
+  bytes -= bytes % m_frame_size;
+
+  // fill() holds m_mutex and read() m_ring_mutex, so both sides are
+  // idle here
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_ring_buffer_size == 0 || bytes <= m_ring_buffer_size) {
+    return;
+  }
+
+  m_ring_buffer_size = bytes;
+
+  // a closed reader allocates with the new size in reopen()
+  {
+    std::lock_guard<std::mutex> ring_lock(m_ring_mutex);
+    if (m_ring_buffer) {
+      m_ring_buffer = grow_ring_buffer(*m_ring_buffer, bytes);
+    }
+  }
+  if (m_seek_ring) {
+    m_seek_ring = grow_ring_buffer(*m_seek_ring, bytes);
+  }
+}
+
+bool
+StreamReader::is_single_file() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::lock_guard<std::mutex> transitions_lock(m_transitions_mutex);
+  return m_next_files.empty() && !m_crossfade && m_transitions.empty();
+}
+
+std::optional<StreamReader::Loop>
+StreamReader::get_loop() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_loop;
+}
+
+void
+StreamReader::set_loop(std::optional<Loop> const& loop)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!loop || !m_loop ||
+      loop->sample_beg != m_loop->sample_beg ||
+      loop->sample_end != m_loop->sample_end)
+  {
+    if (m_loop_head_pos) {
+      // continue behind the part of the head that was already read
+      m_loop_seek = m_loop->sample_beg + static_cast<int64_t>(*m_loop_head_pos / m_frame_size);
+    }
+    clear_loop_head();
+  }
+
+  m_loop = loop;
+  if (m_loop) {
+    m_eof = false;
+  }
+}
+
+void
+StreamReader::set_loop_crossfade(int sample_duration)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_loop_head_pos) {
+    m_loop_seek = m_loop->sample_beg + static_cast<int64_t>(*m_loop_head_pos / m_frame_size);
+  }
+  clear_loop_head();
+
+  m_loop_crossfade = std::max(0, sample_duration);
+}
+
+size_t
+StreamReader::get_loop_head_size() const
+{
+  int64_t const samples = std::min<int64_t>(std::max(m_format.get_rate() * LOOP_HEAD_MSEC / 1000, m_loop_crossfade),
+                                           m_loop->sample_end - m_loop->sample_beg);
+  return m_format.sample2bytes(std::max<int64_t>(0, samples));
+}
+
+void
+StreamReader::clear_loop_head()
+{
+  m_loop_head.clear();
+  m_loop_head_pos = std::nullopt;
+  m_loop_tail.clear();
+}
+
+void
+StreamReader::enqueue(std::unique_ptr<SoundFile> sound_file)
+{
+  SoundFormat const format = sound_file->get_format();
+  if (format.get_rate() != m_format.get_rate() ||
+      format.get_channels() != m_format.get_channels() ||
+      format.get_bits_per_sample() != m_format.get_bits_per_sample()) {
+    throw SoundError("StreamReader::enqueue(): SoundFile format doesn't match the stream");
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_next_files.emplace_back(std::move(sound_file));
+  m_eof = false;
+}
+
+bool
+StreamReader::can_crossfade_to(SoundFormat const& format) const
+{
+  // mixing is only implemented for 16bit
+  return (format.get_rate() == m_format.get_rate() &&
+          format.get_channels() == m_format.get_channels() &&
+          format.get_bits_per_sample() == 16 &&
+          m_format.get_bits_per_sample() == 16);
+}
+
+void
+StreamReader::crossfade_to(std::unique_ptr<SoundFile> sound_file, int sample_duration)
+{
+  if (!can_crossfade_to(sound_file->get_format())) {
+    throw SoundError("StreamReader::crossfade_to(): SoundFile format can't be mixed with the stream");
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // a seek in progress was for the old file
+  m_seek_request = -1;
+  m_seeking = false;
+  m_seek_ready = false;
+  m_seek_pending = false;
+
+  // an older outgoing file still fading gets cut
+  if (sample_duration > 0) {
+    m_crossfade = Crossfade{std::move(m_sound_file), 0, sample_duration};
+  } else {
+    m_crossfade = std::nullopt;
+  }
+
+  m_sound_file = std::move(sound_file);
+  m_sample_duration = m_sound_file->get_sample_duration();
+  m_next_files.clear();
+  m_loop = std::nullopt;
+  clear_loop_head();
+  m_loop_seek = std::nullopt;
+  m_eof = false;
+
+  std::lock_guard<std::mutex> transitions_lock(m_transitions_mutex);
+  m_transitions.emplace_back(Transition{m_samples_produced, m_sample_duration});
+  m_samples_produced = 0;
+}
+
+std::optional<StreamReader::Transition>
+StreamReader::next_transition() const
+{
+  std::lock_guard<std::mutex> lock(m_transitions_mutex);
+  if (m_transitions.empty()) {
+    return std::nullopt;
+  } else {
+    return m_transitions.front();
+  }
+}
+
+void
+StreamReader::pop_transition()
+{
+  std::lock_guard<std::mutex> lock(m_transitions_mutex);
+  if (!m_transitions.empty()) {
+    m_transitions.pop_front();
+  }
+}
+
+size_t
+StreamReader::decode(void* buffer, size_t buffer_size)
+{
+  if (!m_crossfade) {
+    return decode_stream(buffer, buffer_size);
+  }
+
+  char* const data = static_cast<char*>(buffer);
+  size_t const remaining = static_cast<size_t>(m_crossfade->sample_duration - m_crossfade->sample_pos);
+  size_t const len = std::min(buffer_size / m_frame_size, remaining) * m_frame_size;
+
+  size_t const bytesread = decode_stream(data, len);
+  mix_crossfade(data, bytesread);
+
+  if (bytesread < len || m_crossfade->sample_pos >= m_crossfade->sample_duration) {
+    // done, or the new file already ended, release the old decoder
+    m_crossfade = std::nullopt;
+    m_mix = {};
+  }
+
+  if (bytesread < len || bytesread == buffer_size) {
+    return bytesread;
+  } else {
+    return bytesread + decode_stream(data + bytesread, buffer_size - bytesread);
+  }
+}
+
+void
+StreamReader::mix_crossfade(char* buffer, size_t buffer_size)
+{
+  // read the outgoing file, silence once it ended
+  m_mix.resize(buffer_size);
+  size_t total_bytesread = 0;
+  while (total_bytesread < buffer_size)
+  {
+    size_t const bytesread = m_crossfade->sound_file->read(m_mix.data() + total_bytesread,
+                                                           buffer_size - total_bytesread);
+    if (bytesread == 0) { break; }
+    total_bytesread += bytesread;
+  }
+  std::fill(m_mix.begin() + static_cast<std::ptrdiff_t>(total_bytesread), m_mix.end(), 0);
+
+  int const frames = static_cast<int>(buffer_size / m_frame_size);
+  mix_equal_power(reinterpret_cast<int16_t*>(buffer),
+                  reinterpret_cast<int16_t const*>(m_mix.data()),
+                  frames, m_format.get_channels(),
+                  m_crossfade->sample_pos, m_crossfade->sample_duration);
+
+  m_crossfade->sample_pos += frames;
+}
+
+size_t
+StreamReader::decode_stream(void* buffer, size_t buffer_size)
+{
+  char* const data = static_cast<char*>(buffer);
+  size_t total_bytesread = 0;
+  bool wrapped = false;
+
+  while (total_bytesread < buffer_size)
+  {
+    if (m_loop_head_pos)
+    {
+      // serve the start of the loop from the cache
+      size_t const len = std::min(m_loop_head.size() - *m_loop_head_pos, buffer_size - total_bytesread);
+      std::copy_n(m_loop_head.data() + *m_loop_head_pos, len, data + total_bytesread);
+
+      if (*m_loop_head_pos < m_loop_tail.size()) {
+        size_t const fade_len = std::min(len, m_loop_tail.size() - *m_loop_head_pos);
+        mix_equal_power(reinterpret_cast<int16_t*>(data + total_bytesread),
+                        reinterpret_cast<int16_t const*>(m_loop_tail.data() + *m_loop_head_pos),
+                        static_cast<int>(fade_len / m_frame_size), m_format.get_channels(),
+                        static_cast<int>(*m_loop_head_pos / m_frame_size),
+                        static_cast<int>(m_loop_tail.size() / m_frame_size));
+      }
+
+      *m_loop_head_pos += len;
+      total_bytesread += len;
+      m_samples_produced += static_cast<int64_t>(len / m_frame_size);
+
+      if (*m_loop_head_pos == m_loop_head.size()) {
+        m_loop_head_pos = std::nullopt;
+        m_loop_tail.clear();
+      }
+      continue;
+    }
+
+    if (m_loop_seek) {
+      if (total_bytesread > 0) {
+        // leave the seek to the next fill() or, without a ring
+        // buffer, the next read(), so the data served from the loop
+        // head is available without waiting on the SoundFile
+        break;
+      }
+
+      m_sound_file->seek_to_sample(*m_loop_seek);
+      m_loop_seek = std::nullopt;
+    }
+
+    size_t bytesrequested = buffer_size - total_bytesread;
+    size_t const pos = m_sound_file->tell();
+
+    if (m_loop) {
+      size_t const loop_end = m_format.sample2bytes(m_loop->sample_end);
+      bytesrequested = std::min(loop_end > pos ? loop_end - pos : 0, bytesrequested);
+    }
+
+    size_t const bytesread = m_sound_file->read(data + total_bytesread, bytesrequested);
+
+    if (m_loop) {
+      // collect the loop head when the SoundFile passes over it
+      size_t const head_size = get_loop_head_size();
+      if (m_loop_head.size() < head_size &&
+          pos == m_format.sample2bytes(m_loop->sample_beg) + m_loop_head.size()) {
+        size_t const len = std::min(bytesread, head_size - m_loop_head.size());
+        m_loop_head.insert(m_loop_head.end(), data + total_bytesread, data + total_bytesread + len);
+      }
+    }
+
+    total_bytesread += bytesread;
+    m_samples_produced += static_cast<int64_t>(bytesread / m_frame_size);
+
+    if (m_loop) {
+      if (m_sound_file->tell() >= m_format.sample2bytes(m_loop->sample_end) ||
+          bytesread == 0) {
+        if (bytesread == 0 && wrapped) {
+          // empty loop or SoundFile shorter than the loop, don't spin
+          break;
+        }
+
+        size_t const head_size = get_loop_head_size();
+        if (head_size > 0 && m_loop_head.size() == head_size)
+        {
+          if (m_loop_crossfade > 0 && m_format.get_bits_per_sample() == 16 && bytesread != 0) {
+            // keep the audio after the loop end to fade it out
+            m_loop_tail.resize(std::min(m_format.sample2bytes(m_loop_crossfade), head_size));
+            size_t tail_size = 0;
+            while (tail_size < m_loop_tail.size()) {
+              size_t const len = m_sound_file->read(m_loop_tail.data() + tail_size,
+                                                    m_loop_tail.size() - tail_size);
+              if (len == 0) { break; }
+              tail_size += len;
+            }
+            if (tail_size < m_loop_tail.size()) {
+              m_loop_tail.clear();
+            }
+          }
+
+          m_loop_head_pos = 0;
+          m_loop_seek = m_loop->sample_beg + static_cast<int64_t>(head_size / m_frame_size);
+        }
+        else
+        {
+          m_sound_file->seek_to_sample(m_loop->sample_beg);
+        }
+        wrapped = true;
+      } else {
+        wrapped = false;
+      }
+    } else {
+      if (bytesread == 0) {
+        if (!m_next_files.empty()) {
+          // continue with the next file within the same fragment
+          m_sound_file = std::move(m_next_files.front());
+          m_next_files.pop_front();
+          m_sample_duration = m_sound_file->get_sample_duration();
+
+          std::lock_guard<std::mutex> lock(m_transitions_mutex);
+          m_transitions.emplace_back(Transition{m_samples_produced, m_sample_duration});
+          m_samples_produced = 0;
+          continue;
+        }
+
+        /* EOF reached */
+        m_eof = true;
+        break;
+      }
+    }
+  }
+
+  return total_bytesread;
+}
+
+} // namespace wstsound
+
+/* EOF */
@@ -0,0 +1,263 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_STREAM_READER_HPP
+#define HEADER_WSTSOUND_STREAM_READER_HPP
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "ring_buffer.hpp"
+#include "sound_format.hpp"
+
+namespace wstsound {
+
+class SoundFile;
+
+/** StreamReader pulls PCM out of a SoundFile for a StreamSoundSource
+    and handles A-B loops. Without a ring buffer the decoding happens
+    in read(), with one a DecodeWorker decodes ahead of time via fill()
+    and read() only copies already decoded samples. */
+class StreamReader
+{
+public:
+  struct Loop
+  {
+    int64_t sample_beg;
+    int64_t sample_end;
+  };
+
+  /** The point where decoding continued into an enqueued SoundFile */
+  struct Transition
+  {
+    /** Stream position of the first sample of the new file */
+    int64_t sample;
+    int64_t sample_duration;
+  };
+
+public:
+  /** @param ring_buffer_size  Bytes to decode ahead, 0 for synchronous decoding */
+  StreamReader(std::unique_ptr<SoundFile> sound_file, size_t ring_buffer_size = 0);
+  ~StreamReader();
+
+  SoundFormat get_format() const { return m_format; }
+  int64_t get_sample_duration() const { return m_sample_duration; }
+  double get_duration() const;
+
+  /** Consumer side, returns the number of bytes copied into buffer,
+      always a multiple of the frame size */
+  size_t read(void* buffer, size_t buffer_size);
+
+  /** Returns true if read() can deliver 'size' bytes or everything
+      till the end of the stream without waiting on the decoder */
+  bool ready(size_t size) const;
+
+  /** Returns true when the SoundFile is exhausted and all decoded
+      data has been read */
+  bool eof() const;
+
+  /** Producer side, decodes one chunk into the ring buffer, returns
+      false if there was nothing to do */
+  bool fill();
+
+  /** Like fill(), but waits for the DecodeWorker to finish its chunk
+      instead of returning false while it decodes this stream */
+  bool fill_wait();
+
+  bool is_threaded() const { return m_ring_buffer_size > 0; }
+
+  /** Bytes that can be decoded ahead, 0 when not threaded */
+  size_t get_buffer_capacity() const { return m_ring_buffer_size; }
+
+  /** Consumer side, grow the ring buffer to 'bytes' keeping the data
+      already decoded. Smaller sizes and unthreaded readers are left
+      alone. */
+  void grow_buffer_capacity(size_t bytes);
+
+  /** Release the SoundFile and the decoded data, loop settings are
+      kept. The reader must not be read from until reopen(), remove
+      it from the DecodeWorker first. */
+  void close();
+
+  /** Continue with 'sound_file', a fresh instance of the closed one,
+      at 'sample' */
+  void reopen(std::unique_ptr<SoundFile> sound_file, int64_t sample);
+
+  bool is_closed() const { return !m_open; }
+
+  /** True unless files are enqueued or a crossfade is running, only
+      then close() and reopen() get back to the same stream */
+  bool is_single_file() const;
+
+  std::optional<Loop> get_loop() const;
+
+  void seek_to_sample(int64_t sample);
+
+  /** Ask the DecodeWorker to seek, the old data stays readable until
+      the new position has been decoded far enough for complete_seek().
+      A newer request replaces an older one. Only for threaded readers. */
+  void request_seek(int64_t sample);
+
+  /** True from request_seek() until complete_seek() */
+  bool is_seek_pending() const { return m_seek_pending; }
+
+  /** True when complete_seek() can be called */
+  bool is_seek_ready() const { return m_seek_ready; }
+
+  /** Consumer side, replace the buffered data with the data decoded at
+      the requested position, returns that position */
+  int64_t complete_seek();
+
+  void set_loop(std::optional<Loop> const& loop);
+
+  /** Fade the audio following the loop end out over the loop start,
+      only effective for 16bit files with data after the loop end */
+  void set_loop_crossfade(int sample_duration);
+
+  /** Continue decoding with 'sound_file' once the current one hits
+      EOF, the switch happens in the middle of a fragment so there is
+      no gap. While a loop is set the next file is never reached and
+      seeking only applies to the file currently being decoded. */
+  void enqueue(std::unique_ptr<SoundFile> sound_file);
+
+  /** Returns true if crossfade_to() can mix 'format' into this stream */
+  bool can_crossfade_to(SoundFormat const& format) const;
+
+  /** Replace the current file with 'sound_file', mixing both with an
+      equal-power curve over 'sample_duration' samples. The fade starts
+      with the next decoded sample, data already in the ring buffer is
+      not affected, seek first to start it elsewhere. The old decoder
+      is released as soon as it's done. Loops and enqueued files are dropped, the
+      position gets rebased through a Transition like with enqueue(). */
+  void crossfade_to(std::unique_ptr<SoundFile> sound_file, int sample_duration);
+
+  /** Consumer side, the oldest transition not yet acknowledged by
+      pop_transition(). Positions before it belong to the previous
+      file, positions after it are relative to the new one. */
+  std::optional<Transition> next_transition() const;
+  void pop_transition();
+
+  /** Mark the reader as no longer used, the DecodeWorker will drop it */
+  void cancel() { m_cancelled = true; }
+  bool is_cancelled() const { return m_cancelled; }
+
+private:
+  /** Read from the SoundFile, requires m_mutex */
+  size_t decode(void* buffer, size_t buffer_size);
+
+  /** Read from the current file and the queued ones, requires m_mutex */
+  size_t decode_stream(void* buffer, size_t buffer_size);
+
+  /** Mix the outgoing file of a crossfade into 'buffer', requires m_mutex */
+  void mix_crossfade(char* buffer, size_t buffer_size);
+
+  /** Size of the cached loop head in bytes, requires m_mutex */
+  size_t get_loop_head_size() const;
+
+  /** Drop the cached loop head, requires m_mutex */
+  void clear_loop_head();
+
+  /** The part of fill() that decodes, requires m_mutex */
+  bool fill_chunk();
+
+  /** Worker side of request_seek(), requires m_mutex */
+  bool fill_seek();
+
+private:
+  static const size_t FILLCHUNKSIZE = 16384;
+
+  /** Amount of audio after the loop start kept decoded */
+  static const int LOOP_HEAD_MSEC = 250;
+
+  mutable std::mutex m_mutex;
+  std::unique_ptr<SoundFile> m_sound_file;
+  std::deque<std::unique_ptr<SoundFile>> m_next_files;
+  SoundFormat m_format;
+  std::atomic<int64_t> m_sample_duration;
+  size_t m_frame_size;
+  std::optional<Loop> m_loop;
+  int m_loop_crossfade;
+
+  /** PCM following the loop start, lets the loop wrap without waiting
+      on the SoundFile to seek */
+  std::vector<char> m_loop_head;
+
+  /** Read position in m_loop_head while the wrap is served from it */
+  std::optional<size_t> m_loop_head_pos;
+
+  /** Data following the loop end, faded out over the loop head */
+  std::vector<char> m_loop_tail;
+
+  /** Seek of the SoundFile deferred till after the loop head */
+  std::optional<int64_t> m_loop_seek;
+
+  struct Crossfade
+  {
+    std::unique_ptr<SoundFile> sound_file;
+    int sample_pos;
+    int sample_duration;
+  };
+
+  /** The outgoing file of a running crossfade */
+  std::optional<Crossfade> m_crossfade;
+  std::vector<char> m_mix;
+
+  /** Samples produced since the last seek or transition */
+  int64_t m_samples_produced;
+
+  mutable std::mutex m_transitions_mutex;
+  std::deque<Transition> m_transitions;
+
+  std::atomic<size_t> m_ring_buffer_size;
+
+  /** Held by the consumer while it uses m_ring_buffer and by
+      everything that clears or replaces it, taken after m_mutex.
+      read() only tries to lock it, so the mixer thread never waits. */
+  mutable std::mutex m_ring_mutex;
+  std::unique_ptr<RingBuffer> m_ring_buffer;
+  std::atomic<bool> m_eof;
+  std::atomic<bool> m_cancelled;
+
+  /** False between close() and reopen() */
+  std::atomic<bool> m_open;
+
+  /** Second ring buffer that receives the data for an asynchronous
+      seek, swapped with m_ring_buffer on completion */
+  std::unique_ptr<RingBuffer> m_seek_ring;
+  std::atomic<int64_t> m_seek_request;
+  int64_t m_seek_target;
+  bool m_seeking;
+  std::atomic<bool> m_seek_pending;
+  std::atomic<bool> m_seek_ready;
+
+private:
+  StreamReader(const StreamReader&) = delete;
+  StreamReader& operator=(const StreamReader&) = delete;
+};
+
+using StreamReaderPtr = std::shared_ptr<StreamReader>;
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
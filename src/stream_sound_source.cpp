@@ -18,7 +18,9 @@
 
 #include "stream_sound_source.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
 
@@ -27,26 +29,177 @@
 
 namespace wstsound {
 
-StreamSoundSource::StreamSoundSource(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file) :
+StreamSoundSource::StreamSoundSource(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file,
+                                     DecodeWorkerPtr decode_worker,
+                                     StreamBufferPolicy const& policy,
+                                     RefillSchedulerPtr refill_scheduler,
+                                     StreamBufferPoolPtr buffer_pool,
+                                     SourceEventsPtr source_events) :
   OpenALSoundSource(channel),
-  m_sound_file(std::move(sound_file)),
+  m_reader(),
+  m_decode_worker(std::move(decode_worker)),
+  m_refill_scheduler(std::move(refill_scheduler)),
+  m_buffer_pool(buffer_pool ? std::move(buffer_pool) : std::make_shared<StreamBufferPool>()),
+  m_source_events(std::move(source_events)),
+  m_hibernation(),
+  m_reopen(),
+  m_policy(policy),
   m_buffers(),
+  m_free_buffers(),
+  m_fragment(),
+  m_fragments(policy.get_fragments()),
+  m_fragment_size(policy.get_fragment_size()),
+  m_pitch(1.0f),
+  m_update_interval(0.05f),
+  m_last_update(),
+  m_underrun_boost(1.0f),
+  m_stable_time(0.0f),
   m_buffers_queued(false),
-  m_format(m_sound_file->get_format().get_openal_format()),
+  m_queued_samples(0),
+  m_start_pending(false),
+  m_format(sound_file->get_format().get_openal_format()),
   m_total_samples_processed(0),
+  m_sample_duration(sound_file->get_sample_duration()),
   m_state(SourceState::Paused),
-  m_loop()
+  m_declick(false),
+  m_hibernated(false),
+  m_idle_time(0.0f)
 {
-  alGenBuffers(static_cast<ALsizei>(m_buffers.size()), m_buffers.data());
-  OpenALSystem::check_al_error("Couldn't allocate audio buffers: ");
+  size_t const ring_buffer_size = m_decode_worker ? m_policy.get_max_bytes(sound_file->get_format()) : 0;
+  m_reader = std::make_shared<StreamReader>(std::move(sound_file), ring_buffer_size);
+
+  update_buffer_depth();
+
+  if (m_decode_worker) {
+    m_decode_worker->add(m_reader);
+  }
+
+  if (m_source_events) {
+    m_source_events->add(m_source);
+  }
 }
 
 StreamSoundSource::~StreamSoundSource()
 {
+  if (m_hibernation && !m_hibernated) {
+    m_hibernation->closed(*this);
+  }
+
+  if (m_refill_scheduler) {
+    m_refill_scheduler->cancel(*this);
+  }
+
+  if (m_source_events) {
+    m_source_events->remove(m_source);
+  }
+
+  if (m_decode_worker) {
+    m_reader->cancel();
+    m_decode_worker->remove(m_reader);
+  }
+
   clear_queue();
 
-  alDeleteBuffers(static_cast<ALsizei>(m_buffers.size()), m_buffers.data());
-  OpenALSystem::warn_al_error("Couldn't delete audio buffers: ");
+  resize_buffers(0);
+}
+
+void
+StreamSoundSource::enable_hibernation(StreamHibernationPtr hibernation,
+                                      std::function<std::unique_ptr<SoundFile> ()> reopen)
+{
+  m_hibernation = std::move(hibernation);
+  m_reopen = std::move(reopen);
+
+  if (m_hibernation) {
+    m_hibernation->opened(*this);
+  }
+}
+
+bool
+StreamSoundSource::hibernate()
+{
+  if (m_hibernated || !m_reopen ||
+      m_reader->is_seek_pending() ||
+      !m_reader->is_single_file()) {
+    return false;
+  }
+
+  int64_t const sample = get_sample_pos();
+
+  clear_queue();
+  resize_buffers(0);
+
+  if (m_refill_scheduler) {
+    m_refill_scheduler->cancel(*this);
+  }
+
+  if (m_decode_worker) {
+    m_decode_worker->remove(m_reader);
+  }
+  m_reader->close();
+
+  m_total_samples_processed = sample;
+  m_hibernated = true;
+  m_hibernation->closed(*this);
+
+  return true;
+}
+
+void
+StreamSoundSource::wake_up()
+{
+  if (!m_hibernated) { return; }
+
+  int64_t sample = m_total_samples_processed;
+  if (auto const loop = m_reader->get_loop(); loop && sample >= loop->sample_end) {
+    int64_t const length = loop->sample_end - loop->sample_beg;
+    sample = length > 0 ? loop->sample_beg + (sample - loop->sample_beg) % length : loop->sample_beg;
+  }
+  sample = std::clamp<int64_t>(sample, 0, m_sample_duration);
+
+  try
+  {
+    m_reader->reopen(m_reopen(), sample);
+  }
+  catch(std::exception const& err)
+  {
+    std::cerr << "StreamSoundSource: couldn't reopen hibernated stream: " << err.what() << std::endl;
+    m_hibernated = false;
+    m_state = SourceState::Finished;
+    m_start_pending = false;
+    return;
+  }
+
+  m_total_samples_processed = sample;
+  m_hibernated = false;
+  m_idle_time = 0.0f;
+
+  resize_buffers(m_fragments);
+
+  if (m_decode_worker) {
+    // decode the first chunk here, as in play()
+    m_reader->fill();
+    m_decode_worker->add(m_reader);
+  }
+  m_hibernation->opened(*this);
+
+  if (m_state == SourceState::Playing) {
+    m_start_pending = true;
+  }
+}
+
+void
+StreamSoundSource::update_hibernated(float delta)
+{
+  if (m_state != SourceState::Playing) { return; }
+
+  double const rate = static_cast<double>(m_reader->get_format().get_rate());
+  m_total_samples_processed += static_cast<int64_t>(delta * rate * std::max(m_pitch, 0.0f));
+
+  if (!m_reader->get_loop() && m_total_samples_processed >= m_sample_duration) {
+    m_total_samples_processed = m_sample_duration;
+    m_state = SourceState::Finished;
+  }
 }
 
 void
@@ -55,48 +208,152 @@ StreamSoundSource::set_looping(bool looping)
   // Native OpenAL looping will result in only the queue being looped, not
   // the whole song as provided by the SoundFile, so we do it manually.
   if (looping) {
-    m_loop = Loop{0, m_sound_file->get_sample_duration()};
+    m_reader->set_loop(StreamReader::Loop{0, m_sample_duration});
   } else {
-    m_loop = std::nullopt;
+    m_reader->set_loop(std::nullopt);
   }
 }
 
 void
-StreamSoundSource::set_loop(int sample_beg, int sample_end)
+StreamSoundSource::set_loop(int64_t sample_beg, int64_t sample_end)
 {
-  // FIXME: should be handle loops that circle around the end?
-  m_loop = Loop{
-    std::max(sample_beg, 0),
-    std::min(sample_end, m_sound_file->get_sample_duration())
-  };
-
   if (sample_beg > sample_end) {
     throw std::invalid_argument("StreamSoundSource::set_loop(): invalid loop range");
   }
+
+  // FIXME: should be handle loops that circle around the end?
+  m_reader->set_loop(StreamReader::Loop{
+      std::max<int64_t>(sample_beg, 0),
+      std::min(sample_end, m_sample_duration)
+    });
 }
 
 void
-StreamSoundSource::seek_to_sample(int sample)
+StreamSoundSource::set_loop_crossfade(float duration)
 {
+  m_reader->set_loop_crossfade(static_cast<int>(sec_to_sample(duration)));
+}
+
+void
+StreamSoundSource::enqueue(std::unique_ptr<SoundFile> sound_file)
+{
+  wake_up();
+  m_reader->enqueue(std::move(sound_file));
+}
+
+void
+StreamSoundSource::crossfade_to(std::unique_ptr<SoundFile> sound_file, float duration)
+{
+  wake_up();
+
+  // the reader fades from the next sample it decodes, so drop the AL
+  // queue and the ring buffer to have the fade start at what is
+  // audible now; with a transition or a seek pending the play position
+  // isn't in the file the reader is at, then the fade follows the
+  // queued audio
+  bool const requeue = (m_buffers_queued &&
+                        m_reader->is_single_file() &&
+                        !m_reader->is_seek_pending());
+  if (requeue) {
+    seek_to_sample(get_sample_pos());
+    m_declick = true;
+  }
+
+  m_reader->crossfade_to(std::move(sound_file), static_cast<int>(sec_to_sample(duration)));
+
+  if (requeue && m_state == SourceState::Playing) {
+    // restart now rather than with the next update
+    if (m_reader->is_threaded()) {
+      m_reader->fill();
+    }
+    update_queue();
+  }
+
+  if (m_decode_worker) {
+    m_decode_worker->notify();
+  }
+}
+
+void
+StreamSoundSource::set_pitch(float pitch)
+{
+  m_pitch = pitch;
+  OpenALSoundSource::set_pitch(pitch);
+}
+
+void
+StreamSoundSource::set_buffer_policy(StreamBufferPolicy const& policy)
+{
+  m_policy = policy;
+  m_underrun_boost = 1.0f;
+  m_stable_time = 0.0f;
+
+  // the ring buffer was sized for the policy at construction
+  m_reader->grow_buffer_capacity(m_policy.get_max_bytes(m_reader->get_format()));
+
+  update_buffer_depth();
+}
+
+void
+StreamSoundSource::seek_to_sample(int64_t sample)
+{
+  if (m_hibernated) {
+    // picked up by wake_up()
+    m_total_samples_processed = sample;
+    return;
+  }
+
   clear_queue();
 
-  m_sound_file->seek_to_sample(sample);
+  m_reader->seek_to_sample(sample);
   m_total_samples_processed = sample;
+
+  if (m_state == SourceState::Playing) {
+    m_start_pending = true;
+  }
+}
+
+void
+StreamSoundSource::seek_to_sample_async(int64_t sample)
+{
+  if (m_hibernated || !m_reader->is_threaded() || !m_buffers_queued) {
+    // nothing is audible that could be kept playing
+    seek_to_sample(sample);
+    return;
+  }
+
+  m_reader->request_seek(sample);
+  m_decode_worker->notify();
+}
+
+bool
+StreamSoundSource::complete_seek()
+{
+  if (!m_reader->is_seek_ready()) { return false; }
+
+  clear_queue();
+  m_total_samples_processed = m_reader->complete_seek();
+  m_declick = true;
+
+  // restart right away, the old data was dropped by clear_queue()
+  m_start_pending = true;
+
+  return true;
 }
 
 void
-StreamSoundSource::seek_to(float sec)
+StreamSoundSource::seek_to(double sec)
 {
   seek_to_sample(sec_to_sample(sec));
 }
 
-float
+double
 StreamSoundSource::get_pos() const
 {
   return sample_to_sec(get_sample_pos());
 }
 
-int
+int64_t
 StreamSoundSource::get_sample_pos() const
 {
   ALint sample_offset;
@@ -105,16 +362,16 @@ StreamSoundSource::get_sample_pos() const
   return (m_total_samples_processed + sample_offset);
 }
 
-int
+int64_t
 StreamSoundSource::get_sample_duration() const
 {
-  return m_sound_file->get_sample_duration();
+  return m_sample_duration;
 }
 
-float
+double
 StreamSoundSource::get_duration() const
 {
-  return m_sound_file->get_duration();
+  return sample_to_sec(m_sample_duration);
 }
 
 void
@@ -123,9 +380,57 @@ StreamSoundSource::play()
   if (m_state == SourceState::Playing) { return; }
 
   m_state = SourceState::Playing;
+  m_last_update = std::nullopt;
+  m_idle_time = 0.0f;
+  wake_up();
+  if (m_state != SourceState::Playing) { return; }
+
+  if (m_reader->is_threaded() && !m_buffers_queued) {
+    // the worker might not have gotten to this stream yet, decode the
+    // first chunk here so the source doesn't start on an empty queue
+    m_reader->fill();
+  }
 
+  // with the refill scheduler the queue might only get filled in
+  // SoundManager::update(), the source is started once it has data
+  m_start_pending = true;
   update_queue();
-  OpenALSoundSource::play();
+
+  if (m_start_pending)
+  {
+    ALint queued = 0;
+    alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+    if (queued > 0) {
+      m_start_pending = false;
+      OpenALSoundSource::play();
+    }
+  }
+}
+
+void
+StreamSoundSource::preroll()
+{
+  if (m_state != SourceState::Paused || m_buffers_queued) { return; }
+
+  wake_up();
+  if (m_state != SourceState::Paused) { return; }
+
+  m_free_buffers.assign(m_buffers.rbegin(), m_buffers.rend());
+  m_buffers_queued = true;
+
+  // fill the whole AL queue, decoding here whatever the worker hasn't
+  // gotten to yet
+  while (true)
+  {
+    while (queue_fragment() > 0) {}
+
+    ALint queued = 0;
+    alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+    if (queued >= m_fragments || m_free_buffers.empty() || m_reader->eof() ||
+        !m_reader->is_threaded() || !m_reader->fill_wait()) {
+      break;
+    }
+  }
 }
 
 void
@@ -145,6 +450,7 @@ StreamSoundSource::pause()
   if (m_state == SourceState::Paused) { return; }
 
   m_state = SourceState::Paused;
+  m_start_pending = false;
 
   OpenALSoundSource::pause();
 }
@@ -154,18 +460,59 @@ StreamSoundSource::update(float delta)
 {
   OpenALSoundSource::update(delta);
 
+  if (m_hibernation)
+  {
+    bool const audible = (m_state == SourceState::Playing &&
+                          m_channel.get_gain() * get_gain() * m_fade_gain > 0.0f);
+    if (!audible) {
+      m_idle_time += delta;
+    } else {
+      m_idle_time = 0.0f;
+    }
+
+    if (m_hibernated)
+    {
+      if (!audible) {
+        update_hibernated(delta);
+        return;
+      }
+      wake_up();
+    }
+  }
+
   if (m_state == SourceState::Playing)
   {
+    auto const now = std::chrono::steady_clock::now();
+    if (m_last_update) {
+      float const interval = std::chrono::duration<float>(now - *m_last_update).count();
+      if (interval > m_update_interval) {
+        m_update_interval = interval;
+      } else {
+        m_update_interval += (interval - m_update_interval) * 0.01f;
+      }
+      m_stable_time += interval;
+    }
+    m_last_update = now;
+
+    update_buffer_depth();
+
+    if (!needs_update()) {
+      return;
+    }
+
     update_queue();
 
     ALint queued_buffers = 0;
     alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued_buffers);
     if (queued_buffers == 0)
     {
-      // refilling didn't lead to anything getting queued, thus the
-      // SoundFile must have hit EOF, stop the source
-      m_state = SourceState::Finished;
-      OpenALSoundSource::finish();
+      if (m_reader->eof())
+      {
+        // refilling didn't lead to anything getting queued, thus the
+        // SoundFile must have hit EOF, stop the source
+        m_state = SourceState::Finished;
+        OpenALSoundSource::finish();
+      }
     }
     else
     {
@@ -176,66 +523,86 @@ StreamSoundSource::update(float delta)
       if (state == AL_STOPPED)
       {
         std::cerr << "Restarting audio source because of buffer underrun.\n";
+        on_underrun();
         OpenALSoundSource::play();
       }
     }
   }
 }
 
-float
-StreamSoundSource::sample_to_sec(int sample) const
+bool
+StreamSoundSource::needs_update()
 {
-  return static_cast<float>(sample) / static_cast<float>(m_sound_file->get_format().get_rate());
+  if (!m_source_events) {
+    return true;
+  }
+
+  // events only report buffers OpenAL is done with and state
+  // changes, anything waiting for the decoder still has to be polled
+  bool const pending = m_source_events->take(m_source);
+  return (pending ||
+          m_start_pending ||
+          !m_buffers_queued ||
+          !m_free_buffers.empty() ||
+          m_reader->is_seek_ready());
 }
 
-int
-StreamSoundSource::sec_to_sample(float sec) const
+double
+StreamSoundSource::sample_to_sec(int64_t sample) const
 {
-  return static_cast<int>(sec * static_cast<float>(m_sound_file->get_format().get_rate()));
+  return static_cast<double>(sample) / static_cast<double>(m_reader->get_format().get_rate());
 }
 
-void
-StreamSoundSource::fill_buffer_and_queue(ALuint buffer)
+int64_t
+StreamSoundSource::sec_to_sample(double sec) const
 {
-  std::array<char, STREAMFRAGMENTSIZE> bufferdata;
-  size_t total_bytesread = 0;
-
-  // fill buffer with data from m_sound_file
-  do {
-    size_t bytesrequested = STREAMFRAGMENTSIZE - total_bytesread;
+  return static_cast<int64_t>(sec * static_cast<double>(m_reader->get_format().get_rate()));
+}
 
-    if (m_loop) {
-      bytesrequested = std::min(m_sound_file->get_format().sample2bytes(m_loop->sample_end) - m_sound_file->tell(),
-                                bytesrequested);
-    }
+size_t
+StreamSoundSource::fill_buffer_and_queue(ALuint buffer, size_t size)
+{
+  m_fragment.resize(size);
+  size_t const total_bytesread = m_reader->read(m_fragment.data(), m_fragment.size());
 
-    size_t const bytesread = m_sound_file->read(bufferdata.data() + total_bytesread,
-                                                bytesrequested);
-    total_bytesread += bytesread;
+  if (total_bytesread == 0) {
+    return 0;
+  }
 
-    if (m_loop) {
-      if (m_sound_file->tell() >= m_sound_file->get_format().sample2bytes(m_loop->sample_end)) {
-        std::cout << "loop\n";
-        m_sound_file->seek_to_sample(m_loop->sample_beg);
-      }
-    } else {
-      if (bytesread == 0) {
-        /* EOF reached */
-        break;
+  if (m_declick) {
+    m_declick = false;
+
+    SoundFormat const& format = m_reader->get_format();
+    if (format.get_bits_per_sample() == 16) {
+      // 5msec linear fade-in
+      int const channels = format.get_channels();
+      int const frames = std::min(format.get_rate() / 200,
+                                  static_cast<int>(total_bytesread / format.sample2bytes(1)));
+      int16_t* const samples = reinterpret_cast<int16_t*>(m_fragment.data());
+      for(int i = 0; i < frames; ++i) {
+        for(int c = 0; c < channels; ++c) {
+          samples[i * channels + c] = static_cast<int16_t>(samples[i * channels + c] * i / frames);
+        }
       }
     }
-  } while(total_bytesread < STREAMFRAGMENTSIZE);
-
-  if (total_bytesread > 0)
-  {
-    // upload data to the OpenAL buffer
-    alBufferData(buffer, m_format, bufferdata.data(), static_cast<ALsizei>(total_bytesread), m_sound_file->get_format().get_rate());
-    OpenALSystem::check_al_error("Couldn't refill audio buffer: ");
+  }
 
-    // add buffer to the queue of this source
-    alSourceQueueBuffers(m_source, 1, &buffer);
-    OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+  if (m_decode_worker) {
+    m_decode_worker->notify();
   }
+
+  // upload data to the OpenAL buffer
+  alBufferData(buffer, m_format, m_fragment.data(), static_cast<ALsizei>(total_bytesread),
+               m_reader->get_format().get_rate());
+  OpenALSystem::check_al_error("Couldn't refill audio buffer: ");
+
+  // add buffer to the queue of this source
+  alSourceQueueBuffers(m_source, 1, &buffer);
+  OpenALSystem::check_al_error("Couldn't queue audio buffer: ");
+
+  m_queued_samples += static_cast<int64_t>(total_bytesread / m_reader->get_format().sample2bytes(1));
+
+  return total_bytesread;
 }
 
 void
@@ -243,32 +610,108 @@ StreamSoundSource::update_queue()
 {
   if (m_state != SourceState::Playing) { return; }
 
+  complete_seek();
+
   if (!m_buffers_queued)
   {
-    for(auto const& buffer : m_buffers) {
-      fill_buffer_and_queue(buffer);
-    }
+    m_free_buffers.assign(m_buffers.rbegin(), m_buffers.rend());
     m_buffers_queued = true;
   }
   else
-  { // fill the buffer queue with new data
+  {
     ALint processed = 0;
     alGetSourcei(m_source, AL_BUFFERS_PROCESSED, &processed);
 
-    std::array<ALuint, STREAMFRAGMENTS> unqueue_buffers;
+    std::vector<ALuint> unqueue_buffers(processed);
     alSourceUnqueueBuffers(m_source, processed, unqueue_buffers.data());
     OpenALSystem::warn_al_error("Couldn't unqueue audio buffer: ");
 
     for(int i = 0; i < processed; ++i) {
-      fill_buffer_and_queue(unqueue_buffers[i]);
-
-      // FIXME: actual processed sample count might be different if
-      // buffers weren't filled completely
-      m_total_samples_processed += (8 * static_cast<int>(STREAMFRAGMENTSIZE)
-                                    / m_sound_file->get_format().get_channels()
-                                    / m_sound_file->get_format().get_bits_per_sample());
+      ALint size = 0;
+      alGetBufferi(unqueue_buffers[i], AL_SIZE, &size);
+      int const samples = (8 * size
+                           / m_reader->get_format().get_channels()
+                           / m_reader->get_format().get_bits_per_sample());
+      m_total_samples_processed += samples;
+      m_queued_samples -= samples;
+
+      m_free_buffers.emplace_back(unqueue_buffers[i]);
     }
+
+    // release buffers the policy no longer wants
+    resize_buffers(m_fragments);
+
+    update_transitions();
   }
+
+  if (m_refill_scheduler && m_refill_scheduler->is_enabled()) {
+    m_refill_scheduler->request(*this);
+  } else {
+    while (refill_fragment() > 0) {}
+  }
+}
+
+size_t
+StreamSoundSource::refill_fragment()
+{
+  if (m_state != SourceState::Playing) {
+    return 0;
+  }
+
+  return queue_fragment();
+}
+
+size_t
+StreamSoundSource::queue_fragment()
+{
+  if (!m_buffers_queued || m_free_buffers.empty()) {
+    return 0;
+  }
+
+  // when decoding in the background only take full fragments to
+  // avoid running dry
+  ALint queued = 0;
+  alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+  if (queued >= m_fragments ||
+      (queued > 0 && !m_reader->ready(m_fragment_size))) {
+    return 0;
+  }
+
+  // a small first fragment gets the source going sooner, the
+  // following full fragments are queued before it runs out
+  size_t size = m_fragment_size;
+  if (queued == 0) {
+    size_t const frame_size = m_reader->get_format().sample2bytes(1);
+    size = std::max(m_fragment_size / 4, StreamBufferPolicy::MIN_FRAGMENT_SIZE);
+    size = std::min(size - size % frame_size, m_fragment_size);
+  }
+
+  size_t const bytes = fill_buffer_and_queue(m_free_buffers.back(), size);
+  if (bytes == 0) {
+    return 0;
+  }
+  m_free_buffers.pop_back();
+
+  if (m_start_pending) {
+    m_start_pending = false;
+    OpenALSoundSource::play();
+  }
+
+  return bytes;
+}
+
+float
+StreamSoundSource::get_time_to_underrun() const
+{
+  if (m_start_pending) {
+    return RefillScheduler::START_DEADLINE;
+  }
+
+  ALint sample_offset = 0;
+  alGetSourcei(m_source, AL_SAMPLE_OFFSET, &sample_offset);
+
+  float const rate = static_cast<float>(m_reader->get_format().get_rate()) * std::max(m_pitch, 0.01f);
+  return static_cast<float>(std::max<int64_t>(0, m_queued_samples - sample_offset)) / rate;
 }
 
 void
@@ -282,7 +725,121 @@ StreamSoundSource::clear_queue()
 
   alSourcei(m_source, AL_BUFFER, AL_NONE);
 
+  m_free_buffers.clear();
   m_buffers_queued = false;
+  m_queued_samples = 0;
+}
+
+void
+StreamSoundSource::update_transitions()
+{
+  while (auto transition = m_reader->next_transition())
+  {
+    if (get_sample_pos() < transition->sample) {
+      break;
+    }
+
+    m_total_samples_processed -= transition->sample;
+    m_sample_duration = transition->sample_duration;
+    m_reader->pop_transition();
+  }
+}
+
+void
+StreamSoundSource::update_buffer_depth()
+{
+  if (!m_policy.is_adaptive())
+  {
+    m_fragments = m_policy.get_fragments();
+    m_fragment_size = m_policy.get_fragment_size();
+  }
+  else
+  {
+    if (m_stable_time > 10.0f && m_underrun_boost > 1.0f) {
+      m_underrun_boost = std::max(1.0f, m_underrun_boost / 1.5f);
+      m_stable_time = 0.0f;
+    }
+
+    // keep enough audio queued to survive three update() intervals
+    float const latency = std::clamp((3.0f * m_update_interval + 0.05f) * m_underrun_boost,
+                                     m_policy.get_min_latency(),
+                                     m_policy.get_max_latency());
+
+    SoundFormat const& format = m_reader->get_format();
+    size_t const frame_size = format.sample2bytes(1);
+    float const pitch = std::max(m_pitch, 0.01f);
+    size_t const total_bytes = format.sample2bytes(
+      static_cast<int>(latency * pitch * static_cast<float>(format.get_rate())));
+
+    size_t fragment_size = std::clamp(total_bytes / 4,
+                                      StreamBufferPolicy::MIN_FRAGMENT_SIZE,
+                                      StreamBufferPolicy::MAX_FRAGMENT_SIZE);
+    fragment_size -= fragment_size % frame_size;
+
+    int const fragments = std::clamp(static_cast<int>((total_bytes + fragment_size - 1) / fragment_size),
+                                     StreamBufferPolicy::MIN_FRAGMENTS,
+                                     StreamBufferPolicy::MAX_FRAGMENTS);
+
+    m_fragments = fragments;
+    m_fragment_size = fragment_size;
+  }
+
+  if (!m_hibernated) {
+    resize_buffers(m_fragments);
+  }
+
+  if (m_reader->is_threaded()) {
+    // a fragment can't be larger than what the reader can buffer
+    m_fragment_size = std::min(m_fragment_size, m_reader->get_buffer_capacity() / 2);
+  }
+}
+
+void
+StreamSoundSource::resize_buffers(int fragments)
+{
+  size_t const count = static_cast<size_t>(fragments);
+
+  if (count > m_buffers.size())
+  {
+    while (m_buffers.size() < count)
+    {
+      ALuint const buffer = m_buffer_pool->acquire();
+      m_buffers.emplace_back(buffer);
+      if (m_buffers_queued) {
+        m_free_buffers.emplace_back(buffer);
+      }
+    }
+  }
+  else
+  {
+    // only buffers that are not queued can be returned, the rest
+    // follows once OpenAL is done with them
+    while (m_buffers.size() > count)
+    {
+      auto it = m_buffers.end();
+      if (m_buffers_queued) {
+        if (m_free_buffers.empty()) { break; }
+        it = std::find(m_buffers.begin(), m_buffers.end(), m_free_buffers.back());
+        m_free_buffers.pop_back();
+      } else {
+        it = std::prev(m_buffers.end());
+      }
+
+      m_buffer_pool->release(*it);
+      m_buffers.erase(it);
+    }
+  }
+}
+
+void
+StreamSoundSource::on_underrun()
+{
+  m_stable_time = 0.0f;
+
+  if (m_policy.is_adaptive()) {
+    m_underrun_boost = std::min(m_underrun_boost * 1.5f, 8.0f);
+    update_buffer_depth();
+  }
 }
 
 } // namespace wstsound
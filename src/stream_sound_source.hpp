@@ -21,70 +21,179 @@
 
 #include <stdio.h>
 
-#include <array>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <vector>
 
+#include "decode_worker.hpp"
 #include "openal_sound_source.hpp"
+#include "refill_scheduler.hpp"
+#include "source_events.hpp"
+#include "stream_buffer_pool.hpp"
+#include "stream_buffer_policy.hpp"
+#include "stream_hibernation.hpp"
+#include "stream_reader.hpp"
 
 namespace wstsound {
 
 class SoundFile;
 class SoundChannel;
 
-class StreamSoundSource : public OpenALSoundSource
+class StreamSoundSource : public OpenALSoundSource,
+                          private RefillScheduler::Client,
+                          private StreamHibernation::Client
 {
 public:
-  StreamSoundSource(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file);
+  /** If 'decode_worker' is given the SoundFile is decoded ahead of
+      time on the worker threads instead of in update(). With an
+      enabled 'refill_scheduler' the AL queue is refilled when the
+      scheduler gets to it instead of in update(). AL buffers are
+      borrowed from 'buffer_pool', without one the source uses a
+      pool of its own. With 'source_events' OpenAL is only queried
+      when the source had an event or waits for data. */
+  StreamSoundSource(SoundChannel& channel, std::unique_ptr<SoundFile> sound_file,
+                    DecodeWorkerPtr decode_worker = {},
+                    StreamBufferPolicy const& policy = {},
+                    RefillSchedulerPtr refill_scheduler = {},
+                    StreamBufferPoolPtr buffer_pool = {},
+                    SourceEventsPtr source_events = {});
   ~StreamSoundSource() override;
 
+  /** Allow 'hibernation' to release the decoder while the source is
+      paused or inaudible, 'reopen' has to return a fresh instance of
+      the SoundFile to continue with */
+  void enable_hibernation(StreamHibernationPtr hibernation,
+                          std::function<std::unique_ptr<SoundFile> ()> reopen);
+
+  bool is_hibernated() const { return m_hibernated; }
+
   void play() override;
   void pause() override;
+  void preroll() override;
   void finish() override;
 
   SourceState get_state() const override { return m_state; }
 
   void update(float delta) override;
 
-  void seek_to(float sec) override;
-  void seek_to_sample(int sample) override;
+  void seek_to(double sec) override;
+  void seek_to_sample(int64_t sample) override;
+  void seek_to_sample_async(int64_t sample) override;
 
   void set_looping(bool looping) override;
-  void set_loop(int sample_beg, int sample_end) override;
+  void set_loop(int64_t sample_beg, int64_t sample_end) override;
+  void set_loop_crossfade(float duration) override;
+  void enqueue(std::unique_ptr<SoundFile> sound_file) override;
+
+  /** See StreamReader::crossfade_to() */
+  bool can_crossfade_to(SoundFormat const& format) const { return m_reader->can_crossfade_to(format); }
+
+  /** The fade starts at the current play position, what was queued
+      beyond it is dropped and decoded again */
+  void crossfade_to(std::unique_ptr<SoundFile> sound_file, float duration);
+  void set_pitch(float pitch) override;
+  void set_buffer_policy(StreamBufferPolicy const& policy) override;
+
+  /** Number of AL buffers and their size currently in use */
+  int get_fragments() const { return m_fragments; }
+  size_t get_fragment_size() const { return m_fragment_size; }
 
-  float get_pos() const override;
-  float get_duration() const override;
+  double get_pos() const override;
+  double get_duration() const override;
 
-  int get_sample_pos() const override;
-  int get_sample_duration() const override;
+  int64_t get_sample_pos() const override;
+  int64_t get_sample_duration() const override;
 
-  int sec_to_sample(float sec) const override;
-  float sample_to_sec(int sample) const override;
+  int64_t sec_to_sample(double sec) const override;
+  double sample_to_sec(int64_t sample) const override;
 
 private:
-  void fill_buffer_and_queue(ALuint buffer);
+  /** Returns the number of bytes queued */
+  size_t fill_buffer_and_queue(ALuint buffer, size_t size);
+
+  /** Queue one fragment regardless of the state, returns the number
+      of bytes queued */
+  size_t queue_fragment();
+
+  /** False when nothing happened since the last update() that
+      would require to look at the queue */
+  bool needs_update();
+
+  /** Unqueue processed buffers and refill or request a refill */
   void update_queue();
+
+  size_t refill_fragment() override;
+  float get_time_to_underrun() const override;
+
+  float get_idle_time() const override { return m_idle_time; }
+  bool hibernate() override;
+
+  /** Reopen the SoundFile of a hibernated source */
+  void wake_up();
+
+  /** Advance the position of a hibernated source as if it was
+      playing */
+  void update_hibernated(float delta);
+
   void clear_queue();
 
-private:
-  struct Loop
-  {
-    int sample_beg;
-    int sample_end;
-  };
+  /** Swap in the data of a finished asynchronous seek, returns true
+      if the queue was replaced */
+  bool complete_seek();
+
+  /** Recalculate fragment count and size from the policy */
+  void update_buffer_depth();
+
+  /** Rebase the position once playback passed into an enqueued file */
+  void update_transitions();
+  void resize_buffers(int fragments);
+  void on_underrun();
 
 private:
-  static const size_t STREAMFRAGMENTS = 4;
-  static const size_t STREAMFRAGMENTSIZE = 65536;
+  StreamReaderPtr m_reader;
+  DecodeWorkerPtr m_decode_worker;
+  RefillSchedulerPtr m_refill_scheduler;
+  StreamBufferPoolPtr m_buffer_pool;
+  SourceEventsPtr m_source_events;
+  StreamHibernationPtr m_hibernation;
+  std::function<std::unique_ptr<SoundFile> ()> m_reopen;
+  StreamBufferPolicy m_policy;
+  std::vector<ALuint> m_buffers;
+  std::vector<ALuint> m_free_buffers;
+  std::vector<char> m_fragment;
+  int m_fragments;
+  size_t m_fragment_size;
+  float m_pitch;
+
+  /** Peak interval between update() calls, slowly decaying */
+  float m_update_interval;
+  std::optional<std::chrono::steady_clock::time_point> m_last_update;
+  float m_underrun_boost;
+  float m_stable_time;
 
-  std::unique_ptr<SoundFile> m_sound_file;
-  std::array<ALuint, STREAMFRAGMENTS> m_buffers;
   bool m_buffers_queued;
+
+  /** Samples in the AL queue, including the partially played buffer */
+  int64_t m_queued_samples;
+
+  /** play() was called but the source waits for its first fragment */
+  bool m_start_pending;
   ALenum m_format;
-  int m_total_samples_processed;
+  int64_t m_total_samples_processed;
+  int64_t m_sample_duration;
   SourceState m_state;
 
-  std::optional<Loop> m_loop;
+  /** Ramp the next fragment in to hide the cut of an asynchronous seek */
+  bool m_declick;
+
+  /** Decoder and AL buffers are released, m_total_samples_processed
+      holds the position */
+  bool m_hibernated;
+
+  /** Seconds since the source was last audible */
+  float m_idle_time;
 
 public:
   StreamSoundSource(const StreamSoundSource&) = delete;
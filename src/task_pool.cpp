@@ -0,0 +1,80 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "task_pool.hpp"
+
+namespace wstsound {
+
+TaskPool::TaskPool(int num_threads) :
+  m_mutex(),
+  m_cond(),
+  m_quit(false),
+  m_tasks(),
+  m_threads()
+{
+  for (int i = 0; i < num_threads; ++i) {
+    m_threads.emplace_back([this]{ run(); });
+  }
+}
+
+TaskPool::~TaskPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+    m_tasks.clear();
+  }
+  m_cond.notify_all();
+
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void
+TaskPool::post(std::function<void ()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.emplace_back(std::move(task));
+  }
+  m_cond.notify_one();
+}
+
+void
+TaskPool::run()
+{
+  while (true)
+  {
+    std::function<void ()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this]{ return m_quit || !m_tasks.empty(); });
+      if (m_quit) { return; }
+
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+} // namespace wstsound
+
+/* EOF */
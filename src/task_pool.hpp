@@ -0,0 +1,63 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_WSTSOUND_TASK_POOL_HPP
+#define HEADER_WSTSOUND_TASK_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wstsound {
+
+/** Runs posted tasks on a fixed number of background threads, the
+    default executor for SoundManager::preload_async(). Tasks that
+    haven't started when the pool is destroyed are dropped. */
+class TaskPool
+{
+public:
+  TaskPool(int num_threads);
+  ~TaskPool();
+
+  void post(std::function<void ()> task);
+
+  int get_num_threads() const { return static_cast<int>(m_threads.size()); }
+
+private:
+  void run();
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_quit;
+  std::deque<std::function<void ()>> m_tasks;
+  std::vector<std::thread> m_threads;
+
+private:
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+};
+
+} // namespace wstsound
+
+#endif
+
+/* EOF */
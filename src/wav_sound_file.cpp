@@ -174,7 +174,7 @@ WavSoundFile::~WavSoundFile()
 }
 
 void
-WavSoundFile::seek_to_sample(int sample)
+WavSoundFile::seek_to_sample(int64_t sample)
 {
   std::streamoff byte_pos = m_format.sample2bytes(sample);
 
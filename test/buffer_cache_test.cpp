@@ -0,0 +1,91 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "buffer_cache.hpp"
+
+using namespace wstsound;
+
+TEST(BufferCacheTest, evicts_least_recently_used)
+{
+  BufferCache<std::string, std::shared_ptr<int>> cache;
+  cache.set_budget(300);
+
+  cache.insert("a", std::make_shared<int>(1), 100);
+  cache.insert("b", std::make_shared<int>(2), 100);
+  cache.insert("c", std::make_shared<int>(3), 100);
+  EXPECT_EQ(cache.get_size(), 300);
+
+  // "a" is now more recent than "b"
+  EXPECT_EQ(*cache.get("a"), 1);
+
+  cache.insert("d", std::make_shared<int>(4), 100);
+  EXPECT_TRUE(cache.contains("a"));
+  EXPECT_FALSE(cache.contains("b"));
+  EXPECT_EQ(cache.get_size(), 300);
+}
+
+TEST(BufferCacheTest, keeps_used_and_pinned)
+{
+  BufferCache<std::string, std::shared_ptr<int>> cache;
+  cache.set_budget(150);
+
+  cache.insert("pinned", std::make_shared<int>(1), 100, true);
+
+  auto used = std::make_shared<int>(2);
+  cache.insert("used", used, 100);
+  cache.insert("other", std::make_shared<int>(3), 100);
+
+  // nothing but "other" can go, the cache stays over budget
+  EXPECT_FALSE(cache.contains("other"));
+  EXPECT_TRUE(cache.over_budget());
+
+  used.reset();
+  cache.trim();
+  EXPECT_FALSE(cache.contains("used"));
+  EXPECT_EQ(cache.get_size(), 100);
+
+  cache.clear();
+  EXPECT_TRUE(cache.contains("pinned"));
+  EXPECT_EQ(cache.erase_if([](std::string const& key) { return key == "pinned"; }), 1);
+  EXPECT_EQ(cache.get_size(), 0);
+}
+
+TEST(BufferCacheTest, ref_marks_used_and_expires)
+{
+  BufferCache<std::string, std::shared_ptr<int>> cache;
+  cache.set_budget(200);
+
+  cache.insert("a", std::make_shared<int>(1), 100);
+  cache.insert("b", std::make_shared<int>(2), 100);
+  auto ref = cache.get_ref("a");
+
+  // "a" is now more recent than "b"
+  EXPECT_EQ(*cache.get(ref), 1);
+  cache.insert("c", std::make_shared<int>(3), 100);
+  EXPECT_FALSE(cache.contains("b"));
+
+  cache.erase("a");
+  EXPECT_FALSE(cache.get(ref));
+}
+
+/* EOF */
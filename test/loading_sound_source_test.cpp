@@ -0,0 +1,124 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "dummy_sound_source.hpp"
+#include "loading_sound_source.hpp"
+
+using namespace wstsound;
+
+namespace {
+
+/** Remembers seeks and doesn't finish on its own */
+class SeekableSoundSource : public DummySoundSource
+{
+public:
+  SeekableSoundSource() : m_pos(0.0) {}
+
+  double get_duration() const override { return 2.0; }
+  void seek_to(double sec) override { m_pos = sec; }
+  double get_pos() const override { return m_pos; }
+  void update(float delta) override {}
+
+  double m_pos;
+};
+
+} // namespace
+
+TEST(LoadingSoundSourceTest, replays_calls_when_ready)
+{
+  std::promise<std::unique_ptr<SoundFile>> promise;
+  std::shared_ptr<DummySoundSource> dummy;
+
+  LoadingSoundSource source(promise.get_future(),
+                            [&dummy](std::unique_ptr<SoundFile> sound_file) {
+                              dummy = std::make_shared<DummySoundSource>();
+                              return dummy;
+                            });
+  source.play();
+  EXPECT_EQ(source.get_state(), SourceState::Loading);
+
+  source.update(0.0f);
+  EXPECT_EQ(source.get_state(), SourceState::Loading);
+  EXPECT_FALSE(dummy);
+
+  promise.set_value(nullptr);
+  source.update(0.0f);
+  ASSERT_TRUE(dummy);
+  // DummySoundSource::update() finishes right away
+  EXPECT_EQ(source.get_state(), SourceState::Finished);
+}
+
+TEST(LoadingSoundSourceTest, failed_load)
+{
+  std::promise<std::unique_ptr<SoundFile>> promise;
+  LoadingSoundSource source(promise.get_future(),
+                            [](std::unique_ptr<SoundFile> sound_file) -> SoundSourcePtr {
+                              return std::make_shared<DummySoundSource>();
+                            });
+  source.play();
+
+  promise.set_exception(std::make_exception_ptr(std::runtime_error("broken file")));
+  source.update(0.0f);
+  EXPECT_EQ(source.get_state(), SourceState::Finished);
+}
+
+TEST(LoadingSoundSourceTest, catches_up_with_time_spent_loading)
+{
+  std::promise<void> promise;
+  std::shared_ptr<SeekableSoundSource> seekable;
+
+  LoadingSoundSource source(promise.get_future().share(),
+                            [&seekable] {
+                              seekable = std::make_shared<SeekableSoundSource>();
+                              return seekable;
+                            });
+  source.set_max_latency(0.5f);
+  source.play();
+  source.update(0.25f);
+
+  promise.set_value();
+  source.update(0.0f);
+  ASSERT_TRUE(seekable);
+  EXPECT_EQ(seekable->get_state(), SourceState::Playing);
+  EXPECT_DOUBLE_EQ(seekable->get_pos(), 0.25);
+}
+
+TEST(LoadingSoundSourceTest, drops_stale_sound)
+{
+  std::promise<void> promise;
+  std::shared_ptr<SeekableSoundSource> seekable;
+
+  LoadingSoundSource source(promise.get_future().share(),
+                            [&seekable] {
+                              seekable = std::make_shared<SeekableSoundSource>();
+                              return seekable;
+                            });
+  source.set_max_latency(0.1f);
+  source.play();
+  source.update(0.25f);
+
+  promise.set_value();
+  source.update(0.0f);
+  EXPECT_EQ(source.get_state(), SourceState::Finished);
+}
+
+/* EOF */
@@ -0,0 +1,142 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+
+#include "pcm_disk_cache.hpp"
+
+using namespace wstsound;
+
+namespace {
+
+class PCMDiskCacheTest : public ::testing::Test
+{
+protected:
+  PCMDiskCacheTest() :
+    m_dir(std::filesystem::temp_directory_path() /
+          ("wstsound-pcm-cache-test-" + std::to_string(::testing::UnitTest::GetInstance()->random_seed())))
+  {
+  }
+
+  void SetUp() override
+  {
+    std::filesystem::remove_all(m_dir);
+    std::filesystem::create_directories(m_dir);
+    write_source("original");
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove_all(m_dir);
+  }
+
+  void write_source(std::string const& content)
+  {
+    std::ofstream(m_dir / "source.ogg", std::ios::binary | std::ios::trunc) << content;
+  }
+
+  std::filesystem::path m_dir;
+};
+
+} // namespace
+
+TEST_F(PCMDiskCacheTest, stores_and_loads)
+{
+  PCMDiskCache cache(m_dir / "cache", 0, {});
+  std::vector<char> const pcm = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+  SoundFormat format;
+  std::vector<char> data;
+  EXPECT_FALSE(cache.load(m_dir / "source.ogg", format, data));
+
+  cache.store(m_dir / "source.ogg", SoundFormat(44100, 2, 16), pcm.data(), pcm.size());
+  ASSERT_TRUE(cache.load(m_dir / "source.ogg", format, data));
+  EXPECT_EQ(data, pcm);
+  EXPECT_EQ(format.get_rate(), 44100);
+  EXPECT_EQ(format.get_channels(), 2);
+  EXPECT_EQ(format.get_bits_per_sample(), 16);
+}
+
+TEST_F(PCMDiskCacheTest, loads_into_given_memory)
+{
+  PCMDiskCache cache(m_dir / "cache", 0, {});
+  std::vector<char> const pcm = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  cache.store(m_dir / "source.ogg", SoundFormat(22050, 1, 16), pcm.data(), pcm.size());
+
+  EXPECT_FALSE(cache.load(m_dir / "source.ogg", [](SoundFormat const&, size_t) { return nullptr; }));
+
+  std::vector<char> data;
+  ASSERT_TRUE(cache.load(m_dir / "source.ogg", [&data](SoundFormat const& format, size_t size) {
+    EXPECT_EQ(format.get_rate(), 22050);
+    data.resize(size);
+    return data.data();
+  }));
+  EXPECT_EQ(data, pcm);
+}
+
+TEST_F(PCMDiskCacheTest, changed_source_is_a_miss)
+{
+  PCMDiskCache cache(m_dir / "cache", 0, {});
+  std::vector<char> const pcm(16, 1);
+  cache.store(m_dir / "source.ogg", SoundFormat(44100, 1, 16), pcm.data(), pcm.size());
+
+  write_source("modified content");
+
+  SoundFormat format;
+  std::vector<char> data;
+  EXPECT_FALSE(cache.load(m_dir / "source.ogg", format, data));
+}
+
+TEST_F(PCMDiskCacheTest, damaged_entry_is_removed)
+{
+  PCMDiskCache cache(m_dir / "cache", 0, {});
+  std::vector<char> const pcm(16, 1);
+  cache.store(m_dir / "source.ogg", SoundFormat(44100, 1, 16), pcm.data(), pcm.size());
+
+  auto const entry = std::filesystem::directory_iterator(m_dir / "cache")->path();
+  {
+    std::fstream out(entry, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(-1, std::ios::end);
+    out.put(2);
+  }
+
+  SoundFormat format;
+  std::vector<char> data;
+  EXPECT_FALSE(cache.load(m_dir / "source.ogg", format, data));
+  EXPECT_FALSE(std::filesystem::exists(entry));
+}
+
+TEST_F(PCMDiskCacheTest, trims_to_max_bytes)
+{
+  // room for one entry of 64 byte header plus 100 byte PCM
+  PCMDiskCache cache(m_dir / "cache", 200, {});
+  std::vector<char> const pcm(100, 1);
+
+  write_source("a");
+  std::filesystem::copy_file(m_dir / "source.ogg", m_dir / "other.ogg");
+  cache.store(m_dir / "source.ogg", SoundFormat(44100, 1, 16), pcm.data(), pcm.size());
+  cache.store(m_dir / "other.ogg", SoundFormat(44100, 1, 16), pcm.data(), pcm.size());
+
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(m_dir / "cache"),
+                          std::filesystem::directory_iterator()), 1);
+}
+
+/* EOF */
@@ -0,0 +1,169 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "read_ahead_stream.hpp"
+#include "wav_sound_file.hpp"
+
+using namespace wstsound;
+
+namespace {
+
+/** Comes up short once when a read crosses 'fail_at' */
+class FlakyStream : public std::istream
+{
+public:
+  FlakyStream(std::string data, std::streamoff fail_at) :
+    std::istream(nullptr),
+    m_streambuf(std::move(data), fail_at)
+  {
+    rdbuf(&m_streambuf);
+  }
+
+private:
+  class Streambuf : public std::stringbuf
+  {
+  public:
+    Streambuf(std::string data, std::streamoff fail_at) :
+      std::stringbuf(std::move(data), std::ios::in),
+      m_fail_at(fail_at),
+      m_failed(false)
+    {}
+
+  protected:
+    std::streamsize xsgetn(char* s, std::streamsize n) override
+    {
+      std::streamoff const pos = gptr() - eback();
+      if (!m_failed && pos <= m_fail_at && m_fail_at < pos + n) {
+        m_failed = true;
+        n = m_fail_at - pos;
+      }
+      return std::stringbuf::xsgetn(s, n);
+    }
+
+  private:
+    std::streamoff m_fail_at;
+    bool m_failed;
+  };
+
+  Streambuf m_streambuf;
+};
+
+} // namespace
+
+TEST(ReadAheadStreamTest, read_and_seek)
+{
+  std::string data(100000, '\0');
+  for(size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 7 % 251);
+  }
+
+  ReadAheadStream stream(std::make_unique<std::istringstream>(data), std::make_shared<ReadAheadIO>(), 4096, 4);
+
+  std::string head(10000, '\0');
+  ASSERT_TRUE(stream.read(head.data(), static_cast<std::streamsize>(head.size())));
+  EXPECT_EQ(head, data.substr(0, 10000));
+  EXPECT_EQ(stream.tellg(), 10000);
+
+  stream.seekg(-1000, std::ios::end);
+  std::string tail(2000, '\0');
+  stream.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+  EXPECT_EQ(stream.gcount(), 1000);
+  EXPECT_EQ(tail.substr(0, 1000), data.substr(99000));
+  EXPECT_TRUE(stream.eof());
+
+  stream.clear();
+  stream.seekg(5000, std::ios::beg);
+  std::string middle(50000, '\0');
+  ASSERT_TRUE(stream.read(middle.data(), static_cast<std::streamsize>(middle.size())));
+  EXPECT_EQ(middle, data.substr(5000, 50000));
+}
+
+TEST(ReadAheadStreamTest, seek_retries_failed_read)
+{
+  std::string data(100000, '\0');
+  for(size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 7 % 251);
+  }
+
+  ReadAheadStream stream(std::make_unique<FlakyStream>(data, 10000), std::make_shared<ReadAheadIO>(), 4096, 4);
+
+  std::string head(20000, '\0');
+  stream.read(head.data(), static_cast<std::streamsize>(head.size()));
+  EXPECT_EQ(stream.gcount(), 10000);
+  EXPECT_EQ(head.substr(0, 10000), data.substr(0, 10000));
+
+  stream.clear();
+  stream.seekg(5000, std::ios::beg);
+  std::string middle(20000, '\0');
+  ASSERT_TRUE(stream.read(middle.data(), static_cast<std::streamsize>(middle.size())));
+  EXPECT_EQ(middle, data.substr(5000, 20000));
+}
+
+TEST(ReadAheadStreamTest, decode_wav)
+{
+  WavSoundFile plain(std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary));
+  WavSoundFile read_ahead(ReadAheadStream::from_file("data/sound.wav", std::make_shared<ReadAheadIO>()));
+
+  std::vector<char> expected(plain.get_size());
+  std::vector<char> result(read_ahead.get_size());
+  EXPECT_EQ(plain.read(expected.data(), expected.size()), expected.size());
+  EXPECT_EQ(read_ahead.read(result.data(), result.size()), result.size());
+  EXPECT_EQ(expected, result);
+}
+
+TEST(ReadAheadStreamTest, shared_io)
+{
+  auto io = std::make_shared<ReadAheadIO>();
+
+  std::vector<std::string> data;
+  std::vector<std::unique_ptr<ReadAheadStream>> streams;
+  for(int i = 0; i < 4; ++i) {
+    data.emplace_back(30000 + i * 1000, static_cast<char>('a' + i));
+    streams.emplace_back(std::make_unique<ReadAheadStream>(std::make_unique<std::istringstream>(data.back()),
+                                                           io, 1024, 2));
+  }
+
+  // interleaved, so the streams compete for the thread
+  std::vector<std::string> results(streams.size());
+  for(size_t pos = 0; pos < data.back().size(); pos += 500) {
+    for(size_t i = 0; i < streams.size(); ++i) {
+      char buf[500];
+      streams[i]->read(buf, sizeof(buf));
+      results[i].append(buf, static_cast<size_t>(streams[i]->gcount()));
+    }
+  }
+
+  // closing one doesn't disturb the others
+  streams[0].reset();
+  streams[2]->clear();
+  streams[2]->seekg(100, std::ios::beg);
+  char c;
+  ASSERT_TRUE(streams[2]->get(c));
+  EXPECT_EQ(c, 'c');
+
+  for(size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(results[i], data[i]);
+  }
+}
+
+/* EOF */
@@ -0,0 +1,96 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "refill_scheduler.hpp"
+
+using namespace wstsound;
+
+namespace {
+
+class FakeClient : public RefillScheduler::Client
+{
+public:
+  FakeClient(char name, float time_left, int fragments, std::string& log) :
+    m_name(name),
+    m_time_left(time_left),
+    m_fragments(fragments),
+    m_log(log)
+  {}
+
+  float get_time_to_underrun() const override { return m_time_left; }
+
+  size_t refill_fragment() override
+  {
+    if (m_fragments == 0) { return 0; }
+    m_fragments -= 1;
+    m_time_left += 0.1f;
+    m_log += m_name;
+    return 1000;
+  }
+
+private:
+  char m_name;
+  float m_time_left;
+  int m_fragments;
+  std::string& m_log;
+};
+
+} // namespace
+
+TEST(RefillSchedulerTest, most_urgent_first)
+{
+  std::string log;
+  FakeClient a('a', 0.5f, 4, log);
+  FakeClient b('b', 0.05f, 4, log);
+  FakeClient c('c', 0.3f, 1, log);
+
+  RefillScheduler scheduler;
+  scheduler.set_budget(100000);
+  scheduler.request(a);
+  scheduler.request(b);
+  scheduler.request(c);
+  scheduler.request(b);
+  scheduler.run();
+
+  EXPECT_EQ(log, "bbbcbaaaa");
+}
+
+TEST(RefillSchedulerTest, budget)
+{
+  std::string log;
+  FakeClient a('a', 0.5f, 4, log);
+  FakeClient b('b', 0.2f, 4, log);
+
+  RefillScheduler scheduler;
+  scheduler.set_budget(2500);
+  scheduler.request(a);
+  scheduler.request(b);
+  scheduler.cancel(a);
+  scheduler.run();
+  EXPECT_EQ(log, "bbb");
+
+  // requests don't carry over to the next run
+  scheduler.run();
+  EXPECT_EQ(log, "bbb");
+}
+
+/* EOF */
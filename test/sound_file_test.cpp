@@ -46,6 +46,23 @@ size_t get_real_size(SoundFile& soundfile) {
   return total_bytesread;
 }
 
+/** Reports a size without any data behind it */
+class SizeOnlySoundFile : public SoundFile
+{
+public:
+  SizeOnlySoundFile(size_t size, SoundFormat const& format) : m_size(size), m_format(format) {}
+
+  size_t read(void* buffer, size_t buffer_size) override { return 0; }
+  size_t tell() const override { return 0; }
+  void seek_to_sample(int64_t sample) override {}
+  size_t get_size() const override { return m_size; }
+  SoundFormat get_format() const override { return m_format; }
+
+private:
+  size_t m_size;
+  SoundFormat m_format;
+};
+
 } // namespace
 
 TEST(SoundFileTest, wav)
@@ -57,7 +74,7 @@ TEST(SoundFileTest, wav)
   EXPECT_EQ(sound_file.get_format().get_rate(), 44100);
   EXPECT_EQ(sound_file.get_format().get_channels(), 1);
   EXPECT_EQ(sound_file.get_format().get_bits_per_sample(), 16);
-  EXPECT_FLOAT_EQ(sound_file.get_duration(), 0.25836736f);
+  EXPECT_DOUBLE_EQ(sound_file.get_duration(), 11394.0 / 44100.0);
 
   size_t const real_byte_size = get_real_size(sound_file);
   size_t const real_sample_duration = get_sample_duration(sound_file, real_byte_size);
@@ -74,7 +91,7 @@ TEST(SoundFileTest, ogg)
   EXPECT_EQ(sound_file.get_format().get_rate(), 44100);
   EXPECT_EQ(sound_file.get_format().get_channels(), 1);
   EXPECT_EQ(sound_file.get_format().get_bits_per_sample(), 16);
-  EXPECT_FLOAT_EQ(sound_file.get_duration(), 0.25836736f);
+  EXPECT_DOUBLE_EQ(sound_file.get_duration(), 11394.0 / 44100.0);
 
   size_t const real_byte_size = get_real_size(sound_file);
   size_t const real_sample_duration = get_sample_duration(sound_file, real_byte_size);
@@ -91,7 +108,7 @@ TEST(SoundFileTest, opus)
   EXPECT_EQ(sound_file.get_format().get_rate(), 48000);
   EXPECT_EQ(sound_file.get_format().get_channels(), 1);
   EXPECT_EQ(sound_file.get_format().get_bits_per_sample(), 16);
-  EXPECT_FLOAT_EQ(sound_file.get_duration(), 0.25837499f);
+  EXPECT_DOUBLE_EQ(sound_file.get_duration(), 12402.0 / 48000.0);
 
   size_t const real_byte_size = get_real_size(sound_file);
   size_t const real_sample_duration = get_sample_duration(sound_file, real_byte_size);
@@ -108,7 +125,7 @@ TEST(SoundFileTest, mp3)
   EXPECT_EQ(sound_file.get_format().get_rate(), 44100);
   EXPECT_EQ(sound_file.get_format().get_channels(), 1);
   EXPECT_EQ(sound_file.get_format().get_bits_per_sample(), 16);
-  EXPECT_FLOAT_EQ(sound_file.get_duration(), 0.25836736f);
+  EXPECT_DOUBLE_EQ(sound_file.get_duration(), 11394.0 / 44100.0);
 
   size_t const real_byte_size = get_real_size(sound_file);
   size_t const real_sample_duration = get_sample_duration(sound_file, real_byte_size);
@@ -116,4 +133,15 @@ TEST(SoundFileTest, mp3)
   EXPECT_EQ(sound_file.get_sample_duration(), real_sample_duration);
 }
 
+TEST(SoundFileTest, multi_gigabyte_duration)
+{
+  // 14 hours of 48kHz stereo, past both 2^31 bytes and 2^31 samples
+  int64_t const samples = int64_t{48000} * 60 * 60 * 14;
+  SoundFormat const format(48000, 2, 16);
+  SizeOnlySoundFile sound_file(format.sample2bytes(samples), format);
+
+  EXPECT_EQ(sound_file.get_sample_duration(), samples);
+  EXPECT_DOUBLE_EQ(sound_file.get_duration(), 14.0 * 60.0 * 60.0);
+}
+
 /* EOF */
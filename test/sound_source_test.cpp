@@ -24,6 +24,7 @@
 #include "dummy_sound_source.hpp"
 #include "sound_source.hpp"
 #include "static_sound_source.hpp"
+#include "stem_sound_source.hpp"
 #include "stream_sound_source.hpp"
 
 using namespace wstsound;
@@ -52,6 +53,14 @@ TEST(SoundSourceTest, dummy_creation)
   }
 }
 
+TEST(SoundSourceTest, unknown_sound_id)
+{
+  SoundManager mgr;
+  SoundSourcePtr source;
+  EXPECT_NO_THROW(source = mgr.sound().prepare(SoundId{12345}));
+  EXPECT_TRUE(dynamic_cast<DummySoundSource*>(source.get()) != nullptr);
+}
+
 TEST_P(SoundSourceTest, duration)
 {
   SoundManager mgr;
@@ -67,6 +76,32 @@ TEST_P(SoundSourceTest, duration)
   EXPECT_EQ(sound_file->get_duration(), stream_source->get_duration());
 }
 
+TEST(SoundSourceTest, stems_stay_in_lockstep)
+{
+  SoundManager mgr;
+  if (mgr.is_dummy()) { return; }
+
+  for(int decode_threads : {0, 1})
+  {
+    mgr.set_decode_threads(decode_threads);
+
+    auto source = mgr.sound().prepare_stems({"data/left.opus", "data/right.opus"});
+    auto* stems = dynamic_cast<StemSoundSource*>(source.get());
+    ASSERT_TRUE(stems != nullptr);
+
+    // the loop makes the synchronous readers return early at the wrap,
+    // the seek clears the ring buffers of the threaded ones
+    stems->set_loop(1000, 9000);
+    stems->seek_to_sample(500);
+    stems->play();
+
+    for(int i = 0; i < 200 && stems->get_state() == SourceState::Playing; ++i) {
+      mgr.update(0.01f);
+      EXPECT_EQ(stems->get_stem_read_pos(0), stems->get_stem_read_pos(1));
+    }
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
   SoundSourceTests,
   SoundSourceTest,
@@ -0,0 +1,63 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <wstsound/sound_format.hpp>
+#include <wstsound/stream_buffer_policy.hpp>
+
+using namespace wstsound;
+
+TEST(StreamBufferPolicyTest, fixed)
+{
+  StreamBufferPolicy const policy = StreamBufferPolicy::fixed(3, 8192);
+  EXPECT_FALSE(policy.is_adaptive());
+  EXPECT_EQ(policy.get_max_bytes(SoundFormat(48000, 2, 16)), 3 * 8192);
+
+  EXPECT_THROW(StreamBufferPolicy::fixed(1, 8192), std::invalid_argument);
+  EXPECT_THROW(StreamBufferPolicy::fixed(4, 0), std::invalid_argument);
+}
+
+TEST(StreamBufferPolicyTest, get_fixed)
+{
+  StreamBufferPolicy const fixed = StreamBufferPolicy::fixed(3, 8192).get_fixed();
+  EXPECT_EQ(fixed.get_fragments(), 3);
+  EXPECT_EQ(fixed.get_fragment_size(), 8192);
+
+  StreamBufferPolicy const adaptive = StreamBufferPolicy::adaptive().get_fixed();
+  EXPECT_FALSE(adaptive.is_adaptive());
+  EXPECT_EQ(adaptive.get_fragments(), StreamBufferPolicy().get_fragments());
+  EXPECT_EQ(adaptive.get_fragment_size(), StreamBufferPolicy().get_fragment_size());
+}
+
+TEST(StreamBufferPolicyTest, adaptive)
+{
+  StreamBufferPolicy const policy = StreamBufferPolicy::adaptive(0.1f, 2.0f);
+  EXPECT_TRUE(policy.is_adaptive());
+
+  // two seconds of 48kHz stereo
+  EXPECT_EQ(policy.get_max_bytes(SoundFormat(48000, 2, 16)), 384000);
+
+  // never below the minimum queue
+  EXPECT_EQ(policy.get_max_bytes(SoundFormat(1000, 1, 8)),
+            StreamBufferPolicy::MIN_FRAGMENTS * StreamBufferPolicy::MIN_FRAGMENT_SIZE);
+
+  EXPECT_THROW(StreamBufferPolicy::adaptive(2.0f, 1.0f), std::invalid_argument);
+}
+
+/* EOF */
@@ -0,0 +1,96 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "stream_hibernation.hpp"
+
+using namespace wstsound;
+
+namespace {
+
+class FakeClient : public StreamHibernation::Client
+{
+public:
+  FakeClient(StreamHibernation& hibernation, char name, float idle_time, std::string& log) :
+    m_hibernation(hibernation),
+    m_name(name),
+    m_idle_time(idle_time),
+    m_log(log)
+  {
+    m_hibernation.opened(*this);
+  }
+
+  float get_idle_time() const override { return m_idle_time; }
+
+  bool hibernate() override
+  {
+    m_log += m_name;
+    m_hibernation.closed(*this);
+    return true;
+  }
+
+private:
+  StreamHibernation& m_hibernation;
+  char m_name;
+  float m_idle_time;
+  std::string& m_log;
+};
+
+} // namespace
+
+TEST(StreamHibernationTest, idle_timeout)
+{
+  std::string log;
+  StreamHibernation hibernation;
+  FakeClient a(hibernation, 'a', 0.0f, log);
+  FakeClient b(hibernation, 'b', 3.0f, log);
+  FakeClient c(hibernation, 'c', 1.0f, log);
+
+  hibernation.run();
+  EXPECT_EQ(log, "");
+
+  hibernation.set_idle_timeout(2.0f);
+  hibernation.run();
+  EXPECT_EQ(log, "b");
+  EXPECT_EQ(hibernation.get_open_count(), 2);
+}
+
+TEST(StreamHibernationTest, max_open_closes_longest_idle)
+{
+  std::string log;
+  StreamHibernation hibernation;
+  FakeClient a(hibernation, 'a', 0.5f, log);
+  FakeClient b(hibernation, 'b', 0.0f, log);
+  FakeClient c(hibernation, 'c', 2.0f, log);
+  FakeClient d(hibernation, 'd', 0.0f, log);
+
+  hibernation.set_max_open(2);
+  hibernation.run();
+  EXPECT_EQ(log, "ca");
+  EXPECT_EQ(hibernation.get_open_count(), 2);
+
+  // audible streams stay open even over the limit
+  hibernation.set_max_open(1);
+  hibernation.run();
+  EXPECT_EQ(log, "ca");
+}
+
+/* EOF */
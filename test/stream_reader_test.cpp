@@ -0,0 +1,318 @@
+/*
+**  Windstille - A Sci-Fi Action-Adventure Game
+**  Copyright (C) 2026 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <numeric>
+#include <thread>
+
+#include "ring_buffer.hpp"
+#include "stream_reader.hpp"
+#include "wav_sound_file.hpp"
+
+using namespace wstsound;
+
+namespace {
+
+std::vector<char> read_all(StreamReader& reader)
+{
+  std::vector<char> result;
+  std::array<char, 4096> buffer;
+  while (!reader.eof()) {
+    reader.fill();
+    size_t const len = reader.read(buffer.data(), buffer.size());
+    result.insert(result.end(), buffer.begin(), buffer.begin() + len);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(RingBufferTest, wrap_around)
+{
+  RingBuffer ring(8);
+  std::array<char, 8> data;
+  std::iota(data.begin(), data.end(), 0);
+
+  EXPECT_EQ(ring.write(data.data(), 6), 6);
+  EXPECT_EQ(ring.write_available(), 2);
+
+  std::array<char, 8> out;
+  EXPECT_EQ(ring.read(out.data(), 4), 4);
+  EXPECT_EQ(out[3], 3);
+
+  EXPECT_EQ(ring.write(data.data(), 8), 6);
+  EXPECT_EQ(ring.read_available(), 8);
+  EXPECT_EQ(ring.read(out.data(), 8), 8);
+  EXPECT_EQ(out[0], 4);
+  EXPECT_EQ(out[1], 5);
+  EXPECT_EQ(out[2], 0);
+  EXPECT_EQ(out[7], 5);
+  EXPECT_EQ(ring.read_available(), 0);
+}
+
+TEST(RingBufferTest, write_span_stops_at_wrap)
+{
+  RingBuffer ring(8);
+  std::array<char, 8> out;
+
+  ring.commit(6);
+  ring.read(out.data(), 4);
+
+  // 2 bytes till the end of the storage, 2 more after the wrap
+  auto span = ring.write_span();
+  EXPECT_EQ(span.size(), 2);
+  span[0] = 42;
+  ring.commit(2);
+
+  EXPECT_EQ(ring.write_span().size(), 4);
+  EXPECT_EQ(ring.read(out.data(), 8), 4);
+  EXPECT_EQ(out[2], 42);
+}
+
+TEST(StreamReaderTest, threaded_matches_synchronous)
+{
+  StreamReader sync_reader(std::make_unique<WavSoundFile>(
+                             std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  StreamReader ring_reader(std::make_unique<WavSoundFile>(
+                             std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                           4096);
+
+  auto const sync_data = read_all(sync_reader);
+  auto const ring_data = read_all(ring_reader);
+
+  EXPECT_EQ(sync_data.size(), 22788);
+  EXPECT_EQ(sync_data, ring_data);
+}
+
+TEST(StreamReaderTest, enqueue_is_gapless)
+{
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                      4096);
+  reader.enqueue(std::make_unique<WavSoundFile>(
+                   std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+
+  auto const data = read_all(reader);
+  EXPECT_EQ(data.size(), 2 * 22788);
+
+  auto const transition = reader.next_transition();
+  ASSERT_TRUE(transition);
+  EXPECT_EQ(transition->sample, 22788 / 2);
+  EXPECT_EQ(transition->sample_duration, 22788 / 2);
+
+  reader.pop_transition();
+  EXPECT_FALSE(reader.next_transition());
+}
+
+TEST(StreamReaderTest, async_seek_keeps_old_data_until_complete)
+{
+  StreamReader sync_reader(std::make_unique<WavSoundFile>(
+                             std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  StreamReader ring_reader(std::make_unique<WavSoundFile>(
+                             std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                           4096);
+
+  ring_reader.fill();
+  size_t const buffered = 4096;
+
+  ring_reader.request_seek(5000);
+  EXPECT_TRUE(ring_reader.is_seek_pending());
+  while (!ring_reader.is_seek_ready()) {
+    ASSERT_TRUE(ring_reader.fill());
+  }
+
+  // the data decoded before the seek is still there
+  EXPECT_TRUE(ring_reader.ready(buffered));
+  EXPECT_FALSE(ring_reader.fill());
+
+  EXPECT_EQ(ring_reader.complete_seek(), 5000);
+  EXPECT_FALSE(ring_reader.is_seek_pending());
+
+  sync_reader.seek_to_sample(5000);
+  EXPECT_EQ(read_all(ring_reader), read_all(sync_reader));
+}
+
+TEST(StreamReaderTest, crossfade_replaces_stream)
+{
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+
+  std::array<char, 2000> head;
+  EXPECT_EQ(reader.read(head.data(), head.size()), head.size());
+
+  reader.crossfade_to(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                      2000);
+
+  auto const data = read_all(reader);
+  EXPECT_EQ(data.size(), 22788);
+
+  auto const transition = reader.next_transition();
+  ASSERT_TRUE(transition);
+  EXPECT_EQ(transition->sample, 1000);
+  EXPECT_EQ(transition->sample_duration, 22788 / 2);
+}
+
+TEST(StreamReaderTest, loop_wraps_through_cached_head)
+{
+  StreamReader plain_reader(std::make_unique<WavSoundFile>(
+                              std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  auto const plain = read_all(plain_reader);
+
+  // 2 bytes per sample
+  std::vector<char> expected(plain.begin(), plain.begin() + 2 * 9000);
+  for(int i = 0; i < 3; ++i) {
+    expected.insert(expected.end(), plain.begin() + 2 * 1000, plain.begin() + 2 * 9000);
+  }
+
+  for(size_t ring_buffer_size : {size_t{0}, size_t{4096}})
+  {
+    StreamReader reader(std::make_unique<WavSoundFile>(
+                          std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                        ring_buffer_size);
+    reader.set_loop(StreamReader::Loop{1000, 9000});
+
+    std::vector<char> result;
+    std::array<char, 1000> buffer;
+    while (result.size() < expected.size()) {
+      reader.fill();
+      size_t const len = reader.read(buffer.data(), std::min(buffer.size(), expected.size() - result.size()));
+      result.insert(result.end(), buffer.begin(), buffer.begin() + len);
+    }
+
+    EXPECT_EQ(result, expected);
+  }
+}
+
+TEST(StreamReaderTest, synchronous_loop_wrap_defers_seek)
+{
+  StreamReader plain_reader(std::make_unique<WavSoundFile>(
+                              std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  auto const plain = read_all(plain_reader);
+
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  reader.set_loop(StreamReader::Loop{1000, 9000});
+
+  // play up to the loop end, then once through the loop, collecting the head
+  std::vector<char> buffer(2 * 9000);
+  EXPECT_EQ(reader.read(buffer.data(), buffer.size()), buffer.size());
+  EXPECT_EQ(reader.read(buffer.data(), 2 * 8000), 2 * 8000);
+
+  // the wrap only returns the cached head, the seek waits for the next read()
+  size_t const len = reader.read(buffer.data(), buffer.size());
+  EXPECT_GT(len, 0);
+  EXPECT_LT(len, buffer.size());
+  EXPECT_TRUE(std::equal(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(len),
+                         plain.begin() + 2 * 1000));
+}
+
+TEST(StreamReaderTest, reopen_continues_at_position)
+{
+  StreamReader reference(std::make_unique<WavSoundFile>(
+                           std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  auto const full = read_all(reference);
+
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                      4096);
+  reader.close();
+  EXPECT_TRUE(reader.is_closed());
+  EXPECT_FALSE(reader.fill());
+
+  std::array<char, 64> buffer;
+  EXPECT_EQ(reader.read(buffer.data(), buffer.size()), 0);
+
+  int const sample = 1000;
+  reader.reopen(std::make_unique<WavSoundFile>(
+                  std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                sample);
+  auto const rest = read_all(reader);
+
+  size_t const offset = reader.get_format().sample2bytes(sample);
+  ASSERT_EQ(rest.size(), full.size() - offset);
+  EXPECT_TRUE(std::equal(rest.begin(), rest.end(), full.begin() + static_cast<std::ptrdiff_t>(offset)));
+}
+
+TEST(StreamReaderTest, read_during_ring_swaps)
+{
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                      4096);
+
+  // the consumer on its own thread, like the mixer of a callback source
+  std::atomic<bool> quit(false);
+  std::thread consumer([&reader, &quit]{
+    std::array<char, 1024> buffer;
+    while (!quit) {
+      reader.read(buffer.data(), buffer.size());
+      reader.eof();
+    }
+  });
+
+  for(int i = 0; i < 200; ++i) {
+    reader.request_seek(i * 10);
+    while (!reader.is_seek_ready()) { reader.fill(); }
+    reader.complete_seek();
+
+    reader.grow_buffer_capacity(4096 + static_cast<size_t>(i) * 64);
+
+    reader.close();
+    reader.reopen(std::make_unique<WavSoundFile>(
+                    std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                  0);
+    reader.seek_to_sample(i);
+  }
+
+  quit = true;
+  consumer.join();
+}
+
+TEST(StreamReaderTest, fill_wait_fills_ring)
+{
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                      8192);
+
+  while (reader.fill_wait()) {}
+  EXPECT_TRUE(reader.ready(8192));
+}
+
+TEST(StreamReaderTest, grow_keeps_decoded_data)
+{
+  StreamReader reference(std::make_unique<WavSoundFile>(
+                           std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)));
+  auto const full = read_all(reference);
+
+  StreamReader reader(std::make_unique<WavSoundFile>(
+                        std::make_unique<std::ifstream>("data/sound.wav", std::ios::binary)),
+                      4096);
+  while (reader.fill()) {}
+
+  reader.grow_buffer_capacity(16384);
+  EXPECT_EQ(reader.get_buffer_capacity(), 16384);
+  reader.grow_buffer_capacity(1024);
+  EXPECT_EQ(reader.get_buffer_capacity(), 16384);
+
+  auto const data = read_all(reader);
+  EXPECT_EQ(data, full);
+}
+
+/* EOF */